@@ -45,6 +45,7 @@ Application::Application(GLFWwindow* w, size_t initial_width, size_t initial_hei
 
     m_atmosphere = std::make_unique<Atmosphere>(m_drawMeshProgram, 
                                                 m_meshes[0].get());
+    m_governor = std::make_unique<FrameGovernor>(*m_atmosphere);
 
     m_camera = std::make_unique<Camera>(float(m_width) / float(m_height), 
                                         glm::vec3(0, 
@@ -117,6 +118,9 @@ void Application::loop()
 
 void Application::render()
 {
+    // GPU time of the whole frame, including the GUI
+    m_governor->begin_frame();
+
     // --------------------------------------------------------------------------
     // Clear and reset
     // --------------------------------------------------------------------------
@@ -149,6 +153,8 @@ void Application::render()
     }
     // --------------------------------------------------------------------------
 
+    m_governor->end_frame();
+
     m_frames++;
 }
 
@@ -232,6 +238,15 @@ void Application::show_interface()
                 static float g = m_atmosphere->get_mieScatteringDir();
                 static float sunAngle = m_atmosphere->get_sunAngle();
 
+                // Sun also moves on its own when animated, follow its version
+                static Atmosphere::ParamTracker::Stamp sunVersion = 0;
+                const auto& params = m_atmosphere->get_paramTracker();
+                if (sunVersion != params.version(Atmosphere::PARAM_SUN)) {
+                    sunVersion = params.version(Atmosphere::PARAM_SUN);
+                    sunDir = m_atmosphere->get_sunDir();
+                    sunAngle = m_atmosphere->get_sunAngle();
+                }
+
                 ImGui::Separator();
                 ImGui::Text("Sun properties");
                 ImGui::SameLine();
@@ -253,6 +268,9 @@ void Application::show_interface()
                 if (ImGui::Checkbox(" Animate ", &animateSun)) {
                     m_atmosphere->set_animateSun(animateSun);
                 }
+                HelpMarker("In the sky-view mode, the sky of all the sun angles\n"
+                           "is baked once for the altitude of the camera and\n"
+                           "blended during the animation");
 
                 ImGui::Separator();
                 ImGui::Text("Rayleigh Scattering");
@@ -328,9 +346,100 @@ void Application::show_interface()
             if (ImGui::TreeNode("Render options (Dangerous)"))
             {
                 static bool toneMapping = m_atmosphere->is_toneMapping();
+                static int lightIntegrator = m_atmosphere->get_lightIntegrator();
+                static bool adaptiveSampling = m_atmosphere->is_adaptiveSampling();
+                static float transmittanceThreshold = 
+                    m_atmosphere->get_transmittanceThreshold();
+                static bool skipEmptySpace = m_atmosphere->is_skipEmptySpace();
+                static bool multipleScattering = m_atmosphere->is_multipleScattering();
+                static bool spectral = m_atmosphere->is_spectral();
+                static int temporalMode = m_atmosphere->get_temporalMode();
+                static int resolution = m_atmosphere->get_resolutionDivisor() / 2;
+                static bool computeShader = m_atmosphere->is_computeShader();
+                static int renderMode = m_atmosphere->get_renderMode();
+                static int scatteringOrders = m_atmosphere->get_scatteringOrders();
                 static bool renderEarth = m_atmosphere->is_renderEarth();
+                static bool aerialPerspective = m_atmosphere->is_aerialPerspective();
+                static bool skyCapture = m_atmosphere->is_skyCapture();
+                static bool skyAmbientSH = m_atmosphere->is_skyAmbientSH();
+                static bool governor = m_governor->is_enabled();
+                static float budget = m_governor->get_budget();
+
+                // Tuned by the governor on its own, follow its values
+                if (governor) {
+                    viewSamples = m_atmosphere->get_viewSamples();
+                    lightSamples = m_atmosphere->get_lightSamples();
+                    resolution = m_atmosphere->get_resolutionDivisor() / 2;
+                }
 
                 ImGui::Text("Quality options");
+                if (ImGui::Checkbox(" Frame time budget ", &governor)) {
+                    m_governor->set_enabled(governor);
+                }
+                HelpMarker("Measures the GPU time of the frames and tunes the\n"
+                           "view and light samples, and the resolution of the\n"
+                           "ray marching, to hold the budget. Calibrates the\n"
+                           "first frames after enabling. Overrides the sliders");
+                if (governor) {
+                    if (ImGui::SliderFloat("Budget", &budget, 1.f, 33.f, "%.1f ms")) {
+                        m_governor->set_budget(budget);
+                    }
+                }
+                const char* renderModes[] = { "Ray marching", "Precomputed", 
+                                              "Sky-view table", "Analytic",
+                                              "Dome", "CPU reference" };
+                if (ImGui::Combo("Render mode", &renderMode, renderModes, 
+                                 IM_ARRAYSIZE(renderModes))) {
+                    m_atmosphere->set_renderMode(
+                        static_cast<Atmosphere::RenderMode>(renderMode));
+                }
+                HelpMarker("Ray marching integrates single scattering for each\n"
+                           "pixel. Precomputed looks up single and multiple\n"
+                           "scattering in tables, rebuilt on the CPU whenever\n"
+                           "the atmosphere changes. Sky-view table ray marches\n"
+                           "a low resolution map of the sky around the camera\n"
+                           "each frame and stretches it over the screen.\n"
+                           "Analytic evaluates a closed-form model fitted on\n"
+                           "the CPU whenever the atmosphere or the sun change,\n"
+                           "ray marching takes over at high altitudes.\n"
+                           "Dome ray marches the vertices of a fixed mesh\n"
+                           "around the camera and applies only the Mie phase\n"
+                           "function per pixel, independent of the resolution.\n"
+                           "CPU reference ray marches every pixel on all the\n"
+                           "CPU cores without any approximation, as the ground\n"
+                           "truth for the other modes");
+                const char* temporalModes[] = { "Off", "Half of the pixels",
+                                                "Quarter of the pixels" };
+                if (ImGui::Combo("Temporal", &temporalMode, temporalModes,
+                                 IM_ARRAYSIZE(temporalModes))) {
+                    m_atmosphere->set_temporalMode(
+                        static_cast<Atmosphere::TemporalMode>(temporalMode));
+                }
+                HelpMarker("Ray marches only a part of the pixels each frame,\n"
+                           "the rest is reprojected from the previous frames.\n"
+                           "Used when the sky is ray marched per pixel");
+                const char* resolutions[] = { "Full", "Half", "Quarter" };
+                if (ImGui::Combo("Resolution", &resolution, resolutions,
+                                 IM_ARRAYSIZE(resolutions))) {
+                    m_atmosphere->set_resolutionDivisor(1 << resolution);
+                }
+                HelpMarker("Ray marches the sky at a fraction of the window\n"
+                           "size and upsamples it along the edges of the\n"
+                           "planet. Used when the sky is ray marched per pixel");
+                if (m_atmosphere->is_computeSupported()) {
+                    if (ImGui::Checkbox(" Compute shader ", &computeShader)) {
+                        m_atmosphere->set_computeShader(computeShader);
+                    }
+                    HelpMarker("Ray marches the sky by tiles of pixels in a compute\n"
+                               "shader, skipping the tiles of the space and of the\n"
+                               "ground hidden by the planet. Not used with the\n"
+                               "temporal reconstruction");
+                }
+                if (ImGui::SliderInt("Scattering orders", &scatteringOrders, 1, 
+                                     MAX_SCATTERING_ORDERS)) {
+                    m_atmosphere->set_scatteringOrders(scatteringOrders);
+                }
+                HelpMarker("Number of light bounces in the precomputed tables");
                 if (ImGui::DragFloat3("Sun Direction", glm::value_ptr(sunDir), 0.1)) {
                     m_atmosphere->set_animateSun(false);
                     m_atmosphere->set_sunDir(sunDir);
@@ -338,9 +447,51 @@ void Application::show_interface()
                 if (ImGui::SliderInt("View Samples", &viewSamples, 1, 64)) {
                     m_atmosphere->set_viewSamples(viewSamples);
                 }
+                if (ImGui::Checkbox(" Adaptive view samples ", &adaptiveSampling)) {
+                    m_atmosphere->set_adaptiveSampling(adaptiveSampling);
+                }
+                HelpMarker("Samples are denser in the lower layers of the\n"
+                           "atmosphere and fewer on short rays. 8 adaptive\n"
+                           "samples are about as accurate as 16 uniform");
+                if (ImGui::SliderFloat("Termination threshold", &transmittanceThreshold,
+                                       0.f, 0.1f, "%.4f", 
+                                       ImGuiSliderFlags_Logarithmic)) {
+                    m_atmosphere->set_transmittanceThreshold(transmittanceThreshold);
+                }
+                HelpMarker("View ray ends once the transmittance towards the\n"
+                           "camera drops below, 0 disables");
+                if (ImGui::Checkbox(" Skip planet shadow ", &skipEmptySpace)) {
+                    m_atmosphere->set_skipEmptySpace(skipEmptySpace);
+                }
+                HelpMarker("View samples in the shadow of the planet skip\n"
+                           "the light ray, they do not scatter any sunlight");
                 if (ImGui::SliderInt("Light Samples", &lightSamples, 1, 64)) {
                     m_atmosphere->set_lightSamples(lightSamples);
                 }
+                HelpMarker("Used only by the ray marched light integrator");
+                const char* lightIntegrators[] = { "Ray marching", "Transmittance table",
+                                                   "Chapman function" };
+                if (ImGui::Combo("Light integrator", &lightIntegrator, lightIntegrators,
+                                 IM_ARRAYSIZE(lightIntegrators))) {
+                    m_atmosphere->set_lightIntegrator(
+                        static_cast<Atmosphere::LightIntegrator>(lightIntegrator));
+                }
+                HelpMarker("How the light ray of each view sample is computed.\n"
+                           "Ray marching samples it, transmittance table looks\n"
+                           "it up in a precomputed table, Chapman function\n"
+                           "evaluates the optical depth in closed form");
+                if (ImGui::Checkbox(" Multiple scattering ", &multipleScattering)) {
+                    m_atmosphere->set_multipleScattering(multipleScattering);
+                }
+                HelpMarker("Adds light scattered more than once, looked up\n"
+                           "in a small table built on the worker threads");
+                if (ImGui::Checkbox(" Spectral ", &spectral)) {
+                    m_atmosphere->set_spectral(spectral);
+                }
+                HelpMarker("Integrates 8 wavelength bins instead of RGB and\n"
+                           "converts them with the CIE matching functions,\n"
+                           "truer hues at sunset. Without multiple scattering,\n"
+                           "the transmittance table is replaced by Chapman");
                 if (ImGui::Checkbox(" Tone mapping ", &toneMapping)) {
                     m_atmosphere->set_toneMapping(toneMapping);
                 }
@@ -366,6 +517,25 @@ void Application::show_interface()
                 if (ImGui::Checkbox(" Render Ground ", &renderEarth)) {
                     m_atmosphere->set_renderEarth(renderEarth);
                 }
+                HelpMarker("Lit by the sun and by the sky, looked up in tables\n"
+                           "built on the worker threads");
+                if (ImGui::Checkbox(" Sky ambient SH ", &skyAmbientSH)) {
+                    m_atmosphere->set_skyAmbientSH(skyAmbientSH);
+                }
+                HelpMarker("Sky light from 9 spherical harmonics of the sky\n"
+                           "around the camera, projected on the worker threads\n"
+                           "as the sun moves, instead of the table");
+                if (ImGui::Checkbox(" Aerial perspective ", &aerialPerspective)) {
+                    m_atmosphere->set_aerialPerspective(aerialPerspective);
+                }
+                HelpMarker("Ground is seen through the atmosphere, looked up\n"
+                           "in a low resolution volume over the camera frustum");
+                if (ImGui::Checkbox(" Sky cube map ", &skyCapture)) {
+                    m_atmosphere->set_skyCapture(skyCapture);
+                }
+                HelpMarker("Captures the sky around the camera for reflections,\n"
+                           "a tile of a face per frame, the tiles facing\n"
+                           "the moving sun first");
 
                 ImGui::TreePop();
             }
@@ -395,10 +565,32 @@ void Application::status_window()
     // frametime and FPS
     ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 
                 1000.0f / io.Framerate, io.Framerate);
+    ImGui::Text("GPU %.3f ms/frame%s", m_governor->get_frameTime(),
+                m_governor->is_calibrating() ? " (calibrating)" : "");
     ImGui::Text("%u vertices, %u indices (%u triangles)", 
                 m_totalVertices, m_totalIndices, 
                 (uint32_t)(m_totalIndices / 3));
 
+    float iterations = m_atmosphere->get_meanIterations();
+    if (iterations >= 0.f)
+    {
+        // The LUT and the closed form take one sample per light ray
+        int lightSamples = m_atmosphere->get_lightIntegrator() == 
+                           Atmosphere::LIGHT_RAY_MARCHING 
+                               ? m_atmosphere->get_lightSamples() : 1;
+        ImGui::Text("Mean view ray iterations %.2f of %d", 
+                    iterations, m_atmosphere->get_viewSamples());
+        ImGui::Text("Mean light ray iterations %.2f of %d", 
+                    m_atmosphere->get_meanLightIterations(), 
+                    m_atmosphere->get_viewSamples() * lightSamples);
+    }
+    else
+        ImGui::Text("Mean ray iterations n/a in this render mode");
+
+    if (m_atmosphere->get_renderMode() == Atmosphere::RENDER_CPU_REFERENCE)
+        ImGui::Text("CPU reference render %.1f ms", 
+                    m_atmosphere->get_referenceTime() * 1000.0);
+
     ImGui::End();
 }
 
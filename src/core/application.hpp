@@ -18,6 +18,7 @@
 #include "scene/camera.hpp"
 #include "scene/mesh.hpp"
 #include "scene/atmosphere.hpp"
+#include "frame_governor.hpp"
 
 
 /**@brief Controls used in application */
@@ -172,5 +173,6 @@ private:
     uint32_t m_totalVertices, m_totalIndices;
 
     std::unique_ptr<Atmosphere> m_atmosphere;
+    std::unique_ptr<FrameGovernor> m_governor;
 };
 
@@ -0,0 +1,262 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file batch.cpp
+ * @brief Headless offline rendering of frames listed in
+ *        a job file
+ *********************************************************/
+
+#include "pch.hpp"
+#include "batch.hpp"
+#include "cpu/reference_renderer.hpp"
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+
+/** @brief Key varied over the frames of a render */
+struct BatchSweep
+{
+    std::string key;
+    float from, to;
+    int steps;
+};
+
+ReferenceView BatchJob::view() const
+{
+    // Same conventions as Camera and Atmosphere::set_sunAngle
+    float yawRad = glm::radians(yaw);
+    float pitchRad = glm::radians(pitch);
+    glm::vec3 front(std::cos(yawRad) * std::cos(pitchRad), std::sin(pitchRad),
+                    std::sin(yawRad) * std::cos(pitchRad));
+    float sunAngleRad = glm::radians(sunAngle);
+
+    ReferenceView view;
+    view.viewPos = position;
+    view.proj = glm::perspective(glm::radians(fov), float(width) / float(height),
+                                 0.1f, 1000.f);
+    view.view = glm::lookAt(position, position + front, glm::vec3(0.f, 1.f, 0.f));
+    view.sunDir = glm::vec3(0.f, std::sin(sunAngleRad), -std::cos(sunAngleRad));
+    view.viewSamples = viewSamples;
+    view.lightSamples = lightSamples;
+    view.spectral = spectral;
+    return view;
+}
+
+std::string BatchJob::output_name(int frame) const
+{
+    // The pattern is checked by is_output_pattern when read
+    char filename[1024];
+    snprintf(filename, sizeof(filename), output.c_str(), frame);
+    return filename;
+}
+
+/** 
+ * @return Whether the output pattern has exactly one %d or %0Nd conversion
+ *  and no other but %%, so that it is safe to pass to printf
+ */
+static bool is_output_pattern(const std::string& pattern)
+{
+    int conversions = 0;
+    for (size_t i = 0; i < pattern.size(); ++i)
+    {
+        if (pattern[i] != '%')
+            continue;
+
+        if (++i < pattern.size() && pattern[i] == '%')
+            continue;
+
+        // Optional zero padded width
+        if (i < pattern.size() && pattern[i] == '0')
+            while (++i < pattern.size() && std::isdigit(static_cast<unsigned char>(pattern[i])))
+                ;
+        if (i >= pattern.size() || pattern[i] != 'd')
+            return false;
+        ++conversions;
+    }
+    return conversions == 1;
+}
+
+/** @brief Renders a frame of the job and saves it */
+static bool render_frame(ReferenceRenderer& renderer, const BatchJob& job,
+                         int frame)
+{
+    renderer.render(job.params, job.view(), job.width, job.height);
+    const LUT2D& image = renderer.image();
+
+    std::string name = job.output_name(frame);
+
+    bool saved;
+    if (name.size() >= 4 && name.compare(name.size() - 4, 4, ".png") == 0)
+    {
+        // Rows from the top, tone mapped as on the screen
+        std::vector<uint8_t> pixels(size_t(image.width) * image.height *
+                                    CHANNELS_RGB);
+        for (int y = 0; y < image.height; ++y)
+            for (int x = 0; x < image.width; ++x)
+            {
+                glm::vec3 c = image.at(x, image.height - 1 - y);
+                if (job.toneMapping)
+                    c = 1.f - glm::exp(-c);
+                c = glm::clamp(c, 0.f, 1.f) * 255.f + 0.5f;
+
+                uint8_t* p = &pixels[(size_t(y) * image.width + x) * CHANNELS_RGB];
+                p[0] = uint8_t(c.r);
+                p[1] = uint8_t(c.g);
+                p[2] = uint8_t(c.b);
+            }
+        saved = save_png(name.c_str(), pixels.data(), image.width, image.height);
+    }
+    else
+    {
+        saved = save_pfm(name.c_str(), image.ptr(), image.width, image.height);
+    }
+
+    if (saved)
+        LOG_INFO("Frame " << frame << " saved to " << name << " in "
+                 << renderer.render_time() << " s");
+    return saved;
+}
+
+/** @return Index of the name in names, -1 when not found */
+static int find_name(const std::string& name, const std::vector<std::string>& names)
+{
+    for (size_t i = 0; i < names.size(); ++i)
+        if (names[i] == name)
+            return int(i);
+    return -1;
+}
+
+int run_job(const char* jobFile, const FrameCallback& render, 
+            int shard, int shardCount)
+{
+    std::ifstream infile(jobFile);
+    if (!infile)
+    {
+        LOG_ERR("Job file " << jobFile << " does not exist");
+        return -1;
+    }
+
+    // Names of the enums in the order of their values
+    static const std::vector<std::string> renderModes = {
+        "ray_marching", "precomputed", "sky_view", "analytic", "dome"
+    };
+    static const std::vector<std::string> lightIntegrators = {
+        "ray_marching", "transmittance_lut", "chapman"
+    };
+
+    BatchJob job;
+    std::vector<BatchSweep> sweeps;
+    int frame = 0;
+    int failed = 0;
+
+    std::string line;
+    for (int lineNum = 1; std::getline(infile, line); ++lineNum)
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        std::string key;
+        if (!(in >> key))
+            continue;
+
+        if (key == "render")
+        {
+            // All the combinations of the sweeps, the first one varies slowest
+            int frames = 1;
+            for (const BatchSweep& s : sweeps)
+                frames *= s.steps;
+
+            for (int f = 0; f < frames; ++f, ++frame)
+            {
+                if (frame % shardCount != shard)
+                    continue;
+
+                BatchJob swept = job;
+                int index = f;
+                for (int s = int(sweeps.size()) - 1; s >= 0; --s)
+                {
+                    const BatchSweep& sweep = sweeps[s];
+                    int step = index % sweep.steps;
+                    index /= sweep.steps;
+
+                    float t = sweep.steps > 1 ? float(step) / (sweep.steps - 1) : 0.f;
+                    *swept.scalar(sweep.key) = glm::mix(sweep.from, sweep.to, t);
+                }
+
+                if (!render(swept, frame))
+                    ++failed;
+            }
+
+            sweeps.clear();
+            continue;
+        }
+
+        bool ok;
+        if (key == "size")
+            ok = bool(in >> job.width >> job.height) &&
+                 job.width > 0 && job.height > 0;
+        else if (key == "position")
+            ok = bool(in >> job.position.x >> job.position.y >> job.position.z);
+        else if (key == "samples")
+            ok = bool(in >> job.viewSamples >> job.lightSamples) &&
+                 job.viewSamples > 0 && job.lightSamples > 0;
+        else if (key == "rayleigh")
+            ok = bool(in >> job.params.beta_R.r >> job.params.beta_R.g
+                         >> job.params.beta_R.b);
+        else if (key == "tone_mapping")
+            ok = bool(in >> job.toneMapping);
+        else if (key == "spectral")
+            ok = bool(in >> job.spectral);
+        else if (key == "compute_shader")
+            ok = bool(in >> job.computeShader);
+        else if (key == "adaptive_sampling")
+            ok = bool(in >> job.adaptiveSampling);
+        else if (key == "reference_samples")
+            ok = bool(in >> job.referenceViewSamples >> job.referenceLightSamples) &&
+                 job.referenceViewSamples > 0 && job.referenceLightSamples > 0;
+        else if (key == "scattering_orders")
+            ok = bool(in >> job.scatteringOrders) && job.scatteringOrders >= 1 &&
+                 job.scatteringOrders <= MAX_SCATTERING_ORDERS;
+        else if (key == "output")
+            ok = bool(in >> job.output) && is_output_pattern(job.output);
+        else if (key == "gl_mode" || key == "light_integrator")
+        {
+            std::string name;
+            bool mode = key == "gl_mode";
+            int value = in >> name ? 
+                        find_name(name, mode ? renderModes : lightIntegrators) : -1;
+            ok = value >= 0;
+            (mode ? job.renderMode : job.lightIntegrator) = value;
+        }
+        else if (key == "sweep")
+        {
+            BatchSweep s;
+            ok = bool(in >> s.key >> s.from >> s.to >> s.steps) &&
+                 job.scalar(s.key) && s.steps > 0;
+            if (ok)
+                sweeps.push_back(s);
+        }
+        else if (float* value = job.scalar(key))
+            ok = bool(in >> *value);
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            LOG_ERR(jobFile << ":" << lineNum << ": invalid line '" << line << "'");
+            return -1;
+        }
+    }
+
+    LOG_INFO("Job finished, " << frame << " frames in the job, "
+             << failed << " failed");
+    return failed == 0 ? 0 : -1;
+}
+
+int run_batch(const char* jobFile, int shard, int shardCount)
+{
+    ReferenceRenderer renderer;
+    return run_job(jobFile, [&renderer](const BatchJob& job, int frame) {
+        return render_frame(renderer, job, frame);
+    }, shard, shardCount);
+}
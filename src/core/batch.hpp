@@ -0,0 +1,139 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file batch.hpp
+ * @brief Headless offline rendering of frames listed in
+ *        a job file
+ *********************************************************/
+
+#pragma once
+
+#include "scene/atmosphere.hpp"
+
+#include <functional>
+
+
+/** @brief Current values of the job file, see run_batch */
+struct BatchJob
+{
+    int width = 1280;
+    int height = 720;
+    glm::vec3 position;
+    float yaw = 270.f;
+    float pitch = 10.f;
+    float fov = 60.f;
+    int viewSamples = Atmosphere::get_defaultViewSamples();
+    int lightSamples = Atmosphere::get_defaultLightSamples();
+    float sunAngle = 10.f;
+    AtmosphereParams params = Atmosphere::get_defaultParams();
+    bool toneMapping = true;
+    bool spectral = false;
+    std::string output = "frame_%04d.pfm";
+
+    // Used by run_validation only
+    int renderMode = Atmosphere::RENDER_RAY_MARCHING;
+    int lightIntegrator = Atmosphere::LIGHT_RAY_MARCHING;
+    int scatteringOrders = DEFAULT_SCATTERING_ORDERS;
+    bool computeShader = false;
+    bool adaptiveSampling = false;
+    int referenceViewSamples = 0;   ///< Of the CPU reference, 0 follows samples
+    int referenceLightSamples = 0;
+    float maxDeltaE = 1.f;
+    float maxRelativeError = 0.02f;
+
+    // Just above the ground, params are initialized after the position
+    BatchJob() { position = glm::vec3(0.f, params.R_e + 0.001f, 0.f); }
+
+    /** @return Camera and sampling of the frame */
+    ReferenceView view() const;
+
+    /** @return Name of the output file of the frame, from the output pattern */
+    std::string output_name(int frame) const;
+
+    /** @return Single valued key of the job file, nullptr when unknown */
+    float* scalar(const std::string& key)
+    {
+        if (key == "yaw")                return &yaw;
+        if (key == "pitch")              return &pitch;
+        if (key == "fov")                return &fov;
+        if (key == "sun_angle")          return &sunAngle;
+        if (key == "sun_intensity")      return &params.I_sun;
+        if (key == "earth_radius")       return &params.R_e;
+        if (key == "atmos_radius")       return &params.R_a;
+        if (key == "rayleigh_height")    return &params.H_R;
+        if (key == "mie")                return &params.beta_M;
+        if (key == "mie_height")         return &params.H_M;
+        if (key == "mie_dir")            return &params.g;
+        if (key == "max_delta_e")        return &maxDeltaE;
+        if (key == "max_relative_error") return &maxRelativeError;
+        return nullptr;
+    }
+};
+
+/** @brief Renders a frame of a job, returns whether it succeeded */
+using FrameCallback = std::function<bool(const BatchJob& job, int frame)>;
+
+/**
+ * @brief Reads a job file and calls render for each of its frames,
+ *  see run_batch for the format
+ * @param jobFile Path to the job file
+ * @param render Called with the values of each frame
+ * @param shard Index of this process among shardCount processes, frames
+ *              with index % shardCount == shard are rendered
+ * @param shardCount Number of processes sharing the job
+ * @return Exit code of the application, -1 when the file is invalid or
+ *         any of the frames failed
+ */
+int run_job(const char* jobFile, const FrameCallback& render,
+            int shard = 0, int shardCount = 1);
+
+/**
+ * @brief Renders the frames listed in a job file with the CPU reference
+ *  renderer, without a window or an OpenGL context.
+ *
+ *  The job file is read line by line, '#' starts a comment. Each line sets
+ *  a value kept until changed, 'render' renders the frames of the current
+ *  values. Frames are numbered across the whole file.
+ *      size          <width> <height>
+ *      position      <x> <y> <z>         camera position [km]
+ *      yaw, pitch    <degrees>           camera orientation, as in Camera
+ *      fov           <degrees>           vertical field of view
+ *      samples       <view> <light>      samples along the rays
+ *      sun_angle     <degrees>           elevation, as in the GUI
+ *      sun_intensity, earth_radius, atmos_radius, rayleigh_height,
+ *      mie, mie_height, mie_dir <value>  properties of the atmosphere
+ *      rayleigh      <r> <g> <b>         Rayleigh scattering coefficient
+ *      tone_mapping  <0|1>               applied to PNG output only
+ *      spectral      <0|1>               integrates wavelength bins, not RGB
+ *      output        <pattern>           name with a single %d or %0Nd of
+ *                                        the frame index, other '%' escaped
+ *                                        as %%, .pfm for radiance, .png
+ *                                        for 8-bit
+ *      gl_mode       <ray_marching|precomputed|sky_view|analytic|dome>
+ *      light_integrator <ray_marching|transmittance_lut|chapman>
+ *      scattering_orders <1..MAX_SCATTERING_ORDERS>
+ *      compute_shader <0|1>              ray marching by the compute shader,
+ *                                        needs the OpenGL 4.5 build
+ *      adaptive_sampling <0|1>           view samples follow the density
+ *      reference_samples <view> <light>  samples of the CPU reference, the
+ *                                        same as 'samples' by default
+ *      max_delta_e, max_relative_error <value>
+ *                                        OpenGL path and error budget,
+ *                                        used by run_validation only
+ *      sweep         <key> <from> <to> <steps>
+ *                                        varies a single valued key over
+ *                                        the next render, several sweeps
+ *                                        render all their combinations
+ *      render
+ *
+ *  Example, 37 frames of a sunrise:
+ *      size      1920 1080
+ *      output    sunrise_%03d.png
+ *      sweep     sun_angle 0 180 37
+ *      render
+ *
+ * @param jobFile Path to the job file
+ * @param shard See run_job
+ * @param shardCount See run_job
+ * @return Exit code of the application
+ */
+int run_batch(const char* jobFile, int shard = 0, int shardCount = 1);
@@ -0,0 +1,108 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file dependency_tracker.hpp
+ * @brief Version counters of parameters and staleness of
+ *        the products derived from them
+ *********************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+
+
+/**
+ * @brief Tracks which derived products are stale. Every parameter has
+ *  a version counter bumped on each change. Every product remembers the
+ *  versions of its inputs it was last built from, so changing a parameter
+ *  invalidates only the products depending on it.
+ *
+ *  Parameters and products are indices, typically plain enums ending with
+ *  a count.
+ *
+ *  Usage example:
+ *      enum Param { PARAM_RADIUS, PARAM_SUN, PARAM_COUNT };
+ *      enum Product { PRODUCT_TABLE, PRODUCT_COUNT };
+ *
+ *      DependencyTracker<PARAM_COUNT, PRODUCT_COUNT> tracker;
+ *      tracker.depends(PRODUCT_TABLE, { PARAM_RADIUS });
+ *
+ *      tracker.touch(PARAM_SUN);       // table stays up to date
+ *      tracker.touch(PARAM_RADIUS);    // table is stale
+ *      if (tracker.is_stale(PRODUCT_TABLE))
+ *      {
+ *          rebuild();
+ *          tracker.mark_built(PRODUCT_TABLE);
+ *      }
+ *
+ *  Products built asynchronously take a stamp() when the build starts and
+ *  pass it to mark_built() when done, changes made meanwhile keep them stale.
+ */
+template<int PARAMS, int PRODUCTS>
+class DependencyTracker
+{
+public:
+    using Stamp = uint64_t;
+
+    DependencyTracker()
+    {
+        m_versions.fill(1);
+        m_builtFrom.fill(0);
+        m_dependencies.fill(0);
+    }
+
+    /** @brief Declares the parameters the product is derived from */
+    void depends(int product, std::initializer_list<int> params)
+    {
+        for (int param : params)
+            m_dependencies[product] |= uint64_t(1) << param;
+    }
+
+    /** @brief Records a change of the parameter */
+    void touch(int param) { ++m_versions[param]; }
+
+    /** @brief Records a change of all the parameters */
+    void touch_all()
+    {
+        for (auto& version : m_versions)
+            ++version;
+    }
+
+    Stamp version(int param) const { return m_versions[param]; }
+
+    /**
+     * @return Combined version of the inputs of the product, grows whenever
+     *         any of them changes
+     */
+    Stamp stamp(int product) const
+    {
+        Stamp sum = 0;
+        for (int param = 0; param < PARAMS; ++param)
+            if (m_dependencies[product] & (uint64_t(1) << param))
+                sum += m_versions[param];
+        return sum;
+    }
+
+    bool is_stale(int product) const
+    {
+        return m_builtFrom[product] != stamp(product);
+    }
+
+    /** @brief Marks the product as built from the current inputs */
+    void mark_built(int product) { m_builtFrom[product] = stamp(product); }
+
+    /** @brief Marks the product as built from the inputs of an older stamp */
+    void mark_built(int product, Stamp s) { m_builtFrom[product] = s; }
+
+    /** @brief Forces the product to be rebuilt */
+    void invalidate(int product) { m_builtFrom[product] = 0; }
+
+private:
+    static_assert(PARAMS <= 64, "Dependencies are stored as a 64 bit mask");
+
+    std::array<Stamp, PARAMS> m_versions;       ///< Version of each parameter
+    std::array<Stamp, PRODUCTS> m_builtFrom;    ///< Stamp each product was built from
+    std::array<uint64_t, PRODUCTS> m_dependencies;  ///< Bit mask of parameters
+};
+
@@ -0,0 +1,149 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file frame_governor.cpp
+ * @brief Automatic quality of the atmosphere to hold
+ *        a GPU frame time budget
+ *********************************************************/
+
+#include "pch.hpp"
+#include "frame_governor.hpp"
+
+
+FrameGovernor::FrameGovernor(Atmosphere& atmosphere)
+  : m_atmosphere(atmosphere),
+    m_renderMode(atmosphere.get_renderMode())
+{
+    restart_window();
+}
+
+void FrameGovernor::set_enabled(bool b)
+{
+    m_enabled = b;
+    m_calibrating = true;
+    m_saturated = false;
+    m_raiseTime = -1.0;
+    restart_window();
+}
+
+void FrameGovernor::restart_window()
+{
+    m_settle = SETTLE_FRAMES;
+    m_measured = 0;
+    m_sum = 0.0;
+}
+
+void FrameGovernor::begin_frame()
+{
+    m_timer.begin();
+}
+
+void FrameGovernor::end_frame()
+{
+    m_timer.end();
+
+    // The mode changes the cost entirely, so does the blending of the 
+    //  sky-view sequence
+    if (m_renderMode != m_atmosphere.get_renderMode() ||
+        m_skyViewSequence != m_atmosphere.is_skyViewSequenceDrawn())
+    {
+        m_renderMode = m_atmosphere.get_renderMode();
+        m_skyViewSequence = m_atmosphere.is_skyViewSequenceDrawn();
+        m_saturated = false;
+        m_raiseTime = -1.0;
+        restart_window();
+    }
+
+    double ms;
+    while (m_timer.poll(ms))
+    {
+        if (m_settle > 0)
+        {
+            --m_settle;
+            continue;
+        }
+        m_sum += ms;
+        ++m_measured;
+    }
+
+    int window = m_calibrating ? CALIBRATION_FRAMES : WINDOW_FRAMES;
+    if (m_measured < window)
+        return;
+
+    m_frameTime = m_sum / m_measured;
+    m_measured = 0;
+    m_sum = 0.0;
+
+    // The first window after a raise tells whether the samples bound the
+    //  frames, e.g. not when the frames wait on other work
+    if (m_raiseTime > 0.0)
+    {
+        double response = (m_frameTime - m_raiseTime) / 
+                          (m_raiseTime * (m_raiseRatio - 1.0));
+        m_saturated = response < MIN_RESPONSE;
+        m_raiseTime = -1.0;
+    }
+
+    // The sequence is baked once for the samples, every change of them 
+    //  would bake it again while the frames cost the same
+    bool tunable = m_renderMode == Atmosphere::RENDER_RAY_MARCHING ||
+                   (m_renderMode == Atmosphere::RENDER_SKY_VIEW && 
+                    !m_skyViewSequence);
+    if (!m_enabled || !tunable)
+        return;
+
+    double ratio = m_budget / glm::max(m_frameTime, 1e-3);
+    if (m_calibrating)
+    {
+        LOG_INFO("Frame governor calibrated: " << m_frameTime << " ms with "
+                 << m_atmosphere.get_viewSamples() << " view samples");
+        m_calibrating = false;
+        scale_cost(ratio);
+    }
+    else if (m_frameTime > m_budget * (1.f + HYSTERESIS) ||
+             (m_frameTime < m_budget * (1.f - HYSTERESIS) && !m_saturated))
+    {
+        scale_cost(glm::clamp(ratio, 1.0 / MAX_STEP, double(MAX_STEP)));
+    }
+}
+
+void FrameGovernor::scale_cost(double ratio)
+{
+    int samples = m_atmosphere.get_viewSamples();
+    int divisor = m_atmosphere.get_resolutionDivisor();
+
+    // Samples of a full resolution image of the same cost
+    double cost = ratio * samples / double(divisor * divisor);
+
+    // Finest resolution still having the minimum of samples, only the per
+    //  pixel ray marching is rendered at lower resolutions
+    int newDivisor = divisor;
+    if (m_renderMode == Atmosphere::RENDER_RAY_MARCHING)
+    {
+        newDivisor = 1;
+        while (newDivisor < MAX_DIVISOR && 
+               cost * newDivisor * newDivisor < MIN_VIEW_SAMPLES)
+            newDivisor *= 2;
+    }
+    int newSamples = glm::clamp(int(cost * newDivisor * newDivisor + 0.5),
+                                MIN_VIEW_SAMPLES, MAX_VIEW_SAMPLES);
+
+    if (newSamples == samples && newDivisor == divisor)
+        return;
+
+    // Remembered to check that the frame time follows
+    double newCost = newSamples / double(newDivisor * newDivisor);
+    double oldCost = samples / double(divisor * divisor);
+    if (newCost > oldCost)
+    {
+        m_raiseTime = m_frameTime;
+        m_raiseRatio = newCost / oldCost;
+    }
+
+    // Light rays keep the ratio of the defaults
+    int lightSamples = glm::max(1, newSamples * Atmosphere::get_defaultLightSamples() /
+                                   Atmosphere::get_defaultViewSamples());
+    m_atmosphere.set_viewSamples(newSamples);
+    m_atmosphere.set_lightSamples(lightSamples);
+    m_atmosphere.set_resolutionDivisor(newDivisor);
+    restart_window();
+}
@@ -0,0 +1,101 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file frame_governor.hpp
+ * @brief Automatic quality of the atmosphere to hold
+ *        a GPU frame time budget
+ *********************************************************/
+
+#pragma once
+
+#include "opengl/timer_query.hpp"
+#include "scene/atmosphere.hpp"
+
+
+/**
+ * @brief Holds the GPU time of the frames under a budget by tuning the view
+ *  and light samples of the atmosphere and, when ray marched per pixel, its
+ *  resolution divisor. The frames are measured by timer queries between
+ *  begin_frame() and end_frame().
+ *
+ *  The cost is modelled as proportional to the samples per pixel times the 
+ *  pixels, i.e. viewSamples / divisor^2. The mean time of a window of frames
+ *  scales the cost towards the budget, samples are lowered first and the 
+ *  resolution only once the samples reach their minimum. Nothing changes
+ *  while the mean stays within the hysteresis band around the budget, the
+ *  frames right after a change are not measured.
+ *
+ *  When enabled, the first frames calibrate the cost of the current
+ *  settings and jump straight to the settings expected to fit the budget.
+ *  Other render modes, and the sky-view mode while it blends the baked
+ *  sequence of the sun animation, are measured but left as they are.
+ *
+ *  The frames may be bound by other work than the samples, a raise of the
+ *  cost the frame time does not follow stops further raises until the mode
+ *  or the budget changes.
+ */
+class FrameGovernor
+{
+public:
+    /** @param atmosphere Tuned atmosphere, has to outlive the governor */
+    FrameGovernor(Atmosphere& atmosphere);
+
+    /** @brief Starts measuring the GPU work of the frame */
+    void begin_frame();
+
+    /** @brief Stops measuring, adjusts the atmosphere by finished measurements */
+    void end_frame();
+
+    // ----------------------------------------------------------------------------
+    // Getters
+    bool is_enabled() const { return m_enabled; }
+    bool is_calibrating() const { return m_enabled && m_calibrating; }
+    float get_budget() const { return m_budget; }
+    // @return Mean GPU time of the last window of frames in milliseconds
+    double get_frameTime() const { return m_frameTime; }
+
+    // ----------------------------------------------------------------------------
+    // Setters
+    // @brief Enabling starts a new calibration
+    void set_enabled(bool b);
+    // @param ms GPU time of a frame in milliseconds
+    void set_budget(float ms) { m_budget = ms; m_saturated = false; }
+
+private:
+    Atmosphere& m_atmosphere;
+    TimerQuery m_timer;
+
+    bool m_enabled = true;
+    bool m_calibrating = true;      ///< Next window scales without limits
+    float m_budget = DEFAULT_BUDGET;
+    double m_frameTime = 0.0;
+
+    int m_settle = 0;               ///< Measurements left to discard
+    int m_measured = 0;             ///< Measurements in the current window
+    double m_sum = 0.0;             ///< Sum of the current window
+    Atmosphere::RenderMode m_renderMode;
+    bool m_skyViewSequence = false;
+
+    double m_raiseTime = -1.0;      ///< Frame time before the last raise of
+                                    ///  the cost, negative once followed up
+    double m_raiseRatio = 1.0;      ///< Cost ratio of the last raise
+    bool m_saturated = false;       ///< The samples do not bound the frames
+
+    /** @brief Scales the cost of the current settings of the atmosphere */
+    void scale_cost(double ratio);
+
+    /** @brief Discards the current window and the next few measurements */
+    void restart_window();
+
+    inline static const float DEFAULT_BUDGET = 8.f;     ///< [ms]
+    inline static const float HYSTERESIS = 0.15f;       ///< Relative band width
+    inline static const float MAX_STEP = 2.f;           ///< Largest cost ratio
+    inline static const float MIN_RESPONSE = 0.25f;     ///< Part of a raise the
+                                                        ///  frame time follows
+    inline static const int WINDOW_FRAMES = 20;
+    inline static const int CALIBRATION_FRAMES = 30;
+    // Still in flight when the settings change, and the frame after
+    inline static const int SETTLE_FRAMES = TIMER_QUERY_COUNT + 1;
+    inline static const int MIN_VIEW_SAMPLES = 4;
+    inline static const int MAX_VIEW_SAMPLES = 64;      ///< As in the GUI
+    inline static const int MAX_DIVISOR = 4;
+};
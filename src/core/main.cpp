@@ -9,6 +9,8 @@
 
 #include "pch.hpp"
 #include "application.hpp"
+#include "batch.hpp"
+#include "validation.hpp"
 
 #include <GLFW/glfw3.h>
 
@@ -32,7 +34,7 @@ void APIENTRY opengl_debug_callback(GLenum source, GLenum type, GLuint id, GLenu
                                     const void *user_parameter);
 #endif
 
-int main(void)
+int main(int argc, char** argv)
 {
     const size_t initial_width = SCREEN_INIT_WIDTH;
     const size_t initial_height = SCREEN_INIT_HEIGHT;
@@ -42,6 +44,40 @@ int main(void)
 
     // TODO logfile for errors
 
+    // Headless mode, renders a job file on the CPU without any window
+    //  demo --batch <job file> [--shard <index>/<count>]
+    if (argc > 1 && std::string(argv[1]) == "--batch")
+    {
+        int shard = 0, shardCount = 1;
+        bool valid = argc == 3;
+        if (argc == 5 && std::string(argv[3]) == "--shard")
+        {
+            // Whole argument is the index and the count, nothing after
+            int length = 0;
+            valid = sscanf(argv[4], "%d/%d%n", &shard, &shardCount, &length) == 2 &&
+                    argv[4][length] == '\0' && shardCount > 0 && 
+                    shard >= 0 && shard < shardCount;
+        }
+
+        if (!valid)
+        {
+            LOG_ERR("Usage: " << argv[0] 
+                    << " --batch <job file> [--shard <index>/<count>]");
+            return -1;
+        }
+
+        return run_batch(argv[2], shard, shardCount);
+    }
+
+    // Compares the OpenGL path with the CPU reference in a hidden window
+    //  demo --validate <job file>
+    bool validate = argc > 1 && std::string(argv[1]) == "--validate";
+    if (validate && argc != 3)
+    {
+        LOG_ERR("Usage: " << argv[0] << " --validate <job file>");
+        return -1;
+    }
+
     // Initialize GLFW
     if (!glfwInit())
     {
@@ -55,6 +91,7 @@ int main(void)
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+    glfwWindowHint(GLFW_VISIBLE, !validate);
 
     // Create window
     GLFWwindow *window = glfwCreateWindow(initial_width, initial_height, 
@@ -86,6 +123,14 @@ int main(void)
     glDebugMessageCallback(opengl_debug_callback, nullptr);
 #endif
 
+    if (validate)
+    {
+        int result = run_validation(argv[2]);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return result;
+    }
+
     //-------------------------------------------------------------------------
     // Setup Dear ImGUI context
     IMGUI_CHECKVERSION();
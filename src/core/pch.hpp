@@ -43,20 +43,25 @@
 #include "log.hpp"
 
 
-// TODO OpenGL version
-#define OPENGL_VERSION 33           // GCC compatible, only integral comparison
-#define OPENGL_3_3
+// OpenGL version, OPENGL_4_5 is defined by USE_OPENGL_45 in CMakeLists.txt
+#if !defined OPENGL_4_5
+    #define OPENGL_3_3
+#endif
 
 
+// OPENGL_VERSION is GCC compatible, only integral comparison
 #if defined OPENGL_3_3
+    #define OPENGL_VERSION 33
     #define OPENGL_VERSION_MAJOR 3
     #define OPENGL_VERSION_MINOR 3
     #define GLSL_VERSION_STR "#version 330"
 #elif defined OPENGL_4_5
+    #define OPENGL_VERSION 45
     #define OPENGL_VERSION_MAJOR 4
     #define OPENGL_VERSION_MINOR 5
     #define GLSL_VERSION_STR "#version 450"
 #else 
+    #define OPENGL_VERSION 33
     #define OPENGL_VERSION_MAJOR 3
     #define OPENGL_VERSION_MINOR 3
     #define GLSL_VERSION_STR "#version 330"
@@ -10,6 +10,7 @@
 #include "pch.hpp"
 #include "utilities.hpp"
 
+#include <algorithm>
 #include <fstream>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -48,3 +49,121 @@ void free_image_data(uint8_t* data)
     stbi_image_free(data);
 }
 
+bool save_pfm(const char* filename, const float* data, int width, int height)
+{
+    std::ofstream outfile(filename, std::ios::binary);
+    if (!outfile)
+    {
+        LOG_ERR("Could not open " << filename << " for writing");
+        return false;
+    }
+
+    // Negative scale marks little endian data
+    outfile << "PF\n" << width << " " << height << "\n-1.0\n";
+    outfile.write(reinterpret_cast<const char*>(data), 
+                  sizeof(float) * CHANNELS_RGB * width * height);
+
+    return bool(outfile);
+}
+
+/** @brief CRC-32 of PNG chunks, updates a running value */
+static uint32_t png_crc(uint32_t crc, const uint8_t* data, size_t size)
+{
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady)
+    {
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        tableReady = true;
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+/** @brief Appends a big endian 32-bit integer */
+static void png_put32(std::vector<uint8_t>& out, uint32_t v)
+{
+    out.push_back(uint8_t(v >> 24));
+    out.push_back(uint8_t(v >> 16));
+    out.push_back(uint8_t(v >> 8));
+    out.push_back(uint8_t(v));
+}
+
+/** @brief Writes a chunk, type followed by the data, with its length and CRC */
+static void png_chunk(std::ofstream& outfile, const char* type, 
+                      const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> chunk;
+    png_put32(chunk, uint32_t(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    png_put32(chunk, png_crc(0, chunk.data() + 4, chunk.size() - 4));
+
+    outfile.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+bool save_png(const char* filename, const uint8_t* data, int width, int height)
+{
+    std::ofstream outfile(filename, std::ios::binary);
+    if (!outfile)
+    {
+        LOG_ERR("Could not open " << filename << " for writing");
+        return false;
+    }
+
+    const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    outfile.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    // 8-bit RGB, no interlacing
+    std::vector<uint8_t> header;
+    png_put32(header, width);
+    png_put32(header, height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });
+    png_chunk(outfile, "IHDR", header);
+
+    // Scanlines without filtering, each prefixed by the filter type
+    size_t rowSize = size_t(width) * CHANNELS_RGB;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (int y = 0; y < height; ++y)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), data + y * rowSize, data + (y + 1) * rowSize);
+    }
+
+    // Zlib stream of stored (uncompressed) deflate blocks
+    std::vector<uint8_t> zlib = { 0x78, 0x01 };
+    const size_t maxBlock = 65535;
+    for (size_t pos = 0; pos < raw.size(); pos += maxBlock)
+    {
+        size_t size = std::min(maxBlock, raw.size() - pos);
+        zlib.push_back(pos + size >= raw.size() ? 1 : 0);
+        zlib.push_back(uint8_t(size));
+        zlib.push_back(uint8_t(size >> 8));
+        zlib.push_back(uint8_t(~size));
+        zlib.push_back(uint8_t(~size >> 8));
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + size);
+    }
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : raw)
+    {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    png_put32(zlib, (b << 16) | a);
+    png_chunk(outfile, "IDAT", zlib);
+
+    png_chunk(outfile, "IEND", {});
+
+    return bool(outfile);
+}
@@ -46,3 +46,22 @@ uint8_t* load_image(const char* filename,
  */
 void free_image_data(uint8_t* data);
 
+/**
+ * @brief Saves an RGB float image in the Portable Float Map format.
+ * @param filename Path to the image file.
+ * @param data Pixels row by row, starting with the bottom row.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @return Whether the file was written.
+ */
+bool save_pfm(const char* filename, const float* data, int width, int height);
+
+/**
+ * @brief Saves an 8-bit RGB image as an uncompressed PNG.
+ * @param filename Path to the image file.
+ * @param data Pixels row by row, starting with the top row.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @return Whether the file was written.
+ */
+bool save_png(const char* filename, const uint8_t* data, int width, int height);
@@ -0,0 +1,222 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file validation.cpp
+ * @brief Comparison of the OpenGL path with the CPU
+ *        reference over the frames of a job file
+ *********************************************************/
+
+#include "pch.hpp"
+#include "validation.hpp"
+#include "batch.hpp"
+#include "cpu/image_compare.hpp"
+#include "cpu/parallel.hpp"
+#include "opengl/framebuffer.hpp"
+#include "scene/mesh.hpp"
+
+#include <chrono>
+#include <thread>
+
+
+static const double TABLES_TIMEOUT = 120.0;     ///< Seconds to wait for bakes
+
+/** @brief Sets the values of the frame to the atmosphere */
+static void setup_atmosphere(Atmosphere& atmosphere, const BatchJob& job)
+{
+    const AtmosphereParams& p = job.params;
+    atmosphere.set_sunIntensity(p.I_sun);
+    atmosphere.set_earthRadius(p.R_e);
+    atmosphere.set_atmosRadius(p.R_a);
+    atmosphere.set_rayleighScattering(p.beta_R);
+    atmosphere.set_rayleighScaleHeight(p.H_R);
+    atmosphere.set_mieScattering(p.beta_M);
+    atmosphere.set_mieScaleHeight(p.H_M);
+    atmosphere.set_mieScatteringDir(p.g);
+
+    ReferenceView view = job.view();
+    atmosphere.set_projView(view.proj, view.view);
+    atmosphere.set_viewPos(view.viewPos);
+    atmosphere.set_sunDir(view.sunDir);
+    atmosphere.set_viewSamples(view.viewSamples);
+    atmosphere.set_lightSamples(view.lightSamples);
+    atmosphere.set_spectral(view.spectral);
+
+    atmosphere.set_scatteringOrders(job.scatteringOrders);
+    atmosphere.set_computeShader(job.computeShader);
+    atmosphere.set_adaptiveSampling(job.adaptiveSampling);
+
+    atmosphere.set_renderMode(Atmosphere::RenderMode(job.renderMode));
+    atmosphere.set_lightIntegrator(Atmosphere::LightIntegrator(job.lightIntegrator));
+}
+
+/**
+ * @brief Draws the atmosphere into the framebuffer once its tables are
+ *  built and reads the radiance back
+ * @return Whether the tables were built in time
+ */
+static bool render_gl(Atmosphere& atmosphere, Framebuffer& framebuffer,
+                      const BatchJob& job, LUT2D& image)
+{
+    framebuffer.bind();
+    glViewport(0, 0, job.width, job.height);
+
+    // Each draw swaps in the finished bakes
+    auto start = std::chrono::steady_clock::now();
+    atmosphere.draw(0.f);
+    while (!atmosphere.is_upToDate())
+    {
+        std::chrono::duration<double> elapsed = 
+            std::chrono::steady_clock::now() - start;
+        if (elapsed.count() > TABLES_TIMEOUT)
+        {
+            framebuffer.unbind();
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        atmosphere.draw(0.f);
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    atmosphere.draw(0.f);
+
+    // Rows from the bottom as in the reference
+    image.resize(job.width, job.height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, job.width, job.height, GL_RGB, GL_FLOAT, image.data.data());
+
+    framebuffer.unbind();
+    return true;
+}
+
+/**
+ * @brief Renders the sky from the precomputed tables on the CPU, the rays
+ *  of the pixels as in ReferenceRenderer
+ */
+static void render_tables(const ScatteringTables& tables, const BatchJob& job,
+                          LUT2D& image)
+{
+    ReferenceView view = job.view();
+    glm::mat4 invProj = glm::inverse(view.proj);
+    glm::mat3 invView = glm::transpose(glm::mat3(view.view));
+
+    image.resize(job.width, job.height);
+    parallel_for(0, job.height, [&](int y) {
+        for (int x = 0; x < job.width; ++x)
+        {
+            glm::vec2 ndc((x + 0.5f) / job.width * 2.0f - 1.0f,
+                          (y + 0.5f) / job.height * 2.0f - 1.0f);
+            glm::vec4 nearPoint = invProj * glm::vec4(ndc, -1.0f, 1.0f);
+            glm::vec3 dir = glm::normalize(invView * (glm::vec3(nearPoint) / 
+                                                      nearPoint.w));
+
+            image.at(x, y) = tables.sky_radiance(view.viewPos, dir, view.sunDir);
+        }
+    });
+}
+
+int run_validation(const char* jobFile)
+{
+    // Resources of the application, the planet is not drawn
+    auto drawMeshProgram = std::make_shared<Shader>("shaders/draw_mesh.vert",
+                                                    "shaders/draw_mesh.frag");
+    auto meshes = Mesh::from_file("objects/sphere.obj");
+    Atmosphere atmosphere(drawMeshProgram, meshes[0].get());
+    atmosphere.set_renderEarth(false);
+    atmosphere.set_toneMapping(false);
+    atmosphere.set_multipleScattering(false);
+    atmosphere.set_temporalMode(Atmosphere::TEMPORAL_OFF);
+    atmosphere.set_resolutionDivisor(1);
+
+    Texture2D texture(false);
+    texture.set_internal_format(GL_RGBA32F);
+    texture.set_image_format(GL_RGBA);
+    texture.upload((const float*)nullptr, 1, 1);
+    texture.set_filtering(GL_NEAREST, GL_NEAREST);
+    Framebuffer framebuffer;
+    glm::ivec2 size(1, 1);
+
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glEnable(GL_DEPTH_TEST);
+
+    ReferenceRenderer reference;
+    LUT2D image, tablesImage;
+    double worstDeltaE = 0.0, worstError = 0.0;
+
+    int result = run_job(jobFile, [&](const BatchJob& job, int frame) {
+        if (size != glm::ivec2(job.width, job.height))
+        {
+            size = glm::ivec2(job.width, job.height);
+            texture.upload((const float*)nullptr, size.x, size.y);
+            framebuffer.attach_color(texture);
+        }
+
+        // The fragment shader would be validated instead
+        if (job.computeShader && !atmosphere.is_computeSupported())
+        {
+            LOG_ERR("Frame " << frame << ": compute shaders need the "
+                    "OpenGL 4.5 build");
+            return false;
+        }
+
+        setup_atmosphere(atmosphere, job);
+        if (!render_gl(atmosphere, framebuffer, job, image))
+        {
+            LOG_ERR("Frame " << frame << ": tables not built in "
+                    << TABLES_TIMEOUT << " s");
+            return false;
+        }
+        ReferenceView referenceView = job.view();
+        if (job.referenceViewSamples > 0)
+        {
+            referenceView.viewSamples = job.referenceViewSamples;
+            referenceView.lightSamples = job.referenceLightSamples;
+        }
+        reference.render(job.params, referenceView, job.width, job.height);
+
+        ImageDifference diff = compare_images(image, reference.image());
+        worstDeltaE = glm::max(worstDeltaE, diff.meanDeltaE);
+        worstError = glm::max(worstError, diff.relativeError);
+
+        bool passed = diff.meanDeltaE <= job.maxDeltaE && 
+                      diff.relativeError <= job.maxRelativeError;
+        LOG_INFO("Frame " << frame << (passed ? " passed" : " FAILED")
+                 << ": mean dE " << diff.meanDeltaE << " (max " 
+                 << diff.maxDeltaE << "), relative error " << diff.relativeError);
+
+        // The tables themselves, within the same budget
+        bool tablesPassed = true;
+        if (job.renderMode == Atmosphere::RENDER_PRECOMPUTED)
+        {
+            render_tables(atmosphere.get_scatteringTables(), job, tablesImage);
+            ImageDifference tablesDiff = compare_images(tablesImage, 
+                                                        reference.image());
+            worstDeltaE = glm::max(worstDeltaE, tablesDiff.meanDeltaE);
+            worstError = glm::max(worstError, tablesDiff.relativeError);
+
+            tablesPassed = tablesDiff.meanDeltaE <= job.maxDeltaE && 
+                           tablesDiff.relativeError <= job.maxRelativeError;
+            LOG_INFO("Frame " << frame << " tables" 
+                     << (tablesPassed ? " passed" : " FAILED")
+                     << ": mean dE " << tablesDiff.meanDeltaE << " (max " 
+                     << tablesDiff.maxDeltaE << "), relative error " 
+                     << tablesDiff.relativeError);
+        }
+
+        if (!passed || !tablesPassed)
+        {
+            std::string name = job.output_name(frame);
+            std::string stem = name.substr(0, name.rfind('.'));
+            save_pfm((stem + ".pfm").c_str(), image.ptr(), image.width, image.height);
+            save_pfm((stem + "_ref.pfm").c_str(), reference.image().ptr(),
+                     image.width, image.height);
+            if (!tablesPassed)
+                save_pfm((stem + "_tables.pfm").c_str(), tablesImage.ptr(),
+                         image.width, image.height);
+        }
+        return passed && tablesPassed;
+    });
+
+    LOG_INFO("Validation " << (result == 0 ? "passed" : "failed") 
+             << ", worst mean dE " << worstDeltaE 
+             << ", worst relative error " << worstError);
+    return result;
+}
@@ -0,0 +1,40 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file validation.hpp
+ * @brief Comparison of the OpenGL path with the CPU
+ *        reference over the frames of a job file
+ *********************************************************/
+
+#pragma once
+
+
+/**
+ * @brief Renders the frames of a job file (see run_batch) with the OpenGL
+ *  path and with the CPU reference renderer and compares them, to catch
+ *  drift of the shaders from the ground truth. Expects a current OpenGL
+ *  context, a hidden window is enough, Mesa llvmpipe included.
+ *
+ *  The OpenGL path renders single scattering of the sky only, without 
+ *  the planet and tone mapping, into a float framebuffer. A frame fails
+ *  when its mean color difference exceeds max_delta_e or its relative
+ *  error exceeds max_relative_error (see compare_images). The 'output' 
+ *  of failed frames receives the OpenGL image as .pfm, the reference
+ *  next to it with the _ref suffix.
+ *
+ *  In the precomputed mode, the sky is also computed from the baked tables
+ *  on the CPU (see ScatteringTables::sky_radiance) and compared with the
+ *  same budget, saved with the _tables suffix when failed. Single 
+ *  scattering is compared, the job sets scattering_orders 1.
+ *
+ *  Example, the LUT integrator over a day:
+ *      size              256 144
+ *      light_integrator  transmittance_lut
+ *      max_delta_e       0.5
+ *      output            drift_%02d.pfm
+ *      sweep             sun_angle 0 90 7
+ *      render
+ *
+ * @param jobFile Path to the job file
+ * @return Exit code of the application, -1 when any of the frames failed
+ */
+int run_validation(const char* jobFile);
@@ -0,0 +1,174 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file analytic_sky.cpp
+ * @brief Closed-form sky fitted to the ray marched model
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "analytic_sky.hpp"
+#include "parallel.hpp"
+#include "reference_renderer.hpp"
+
+
+#define ANALYTIC_SKY_CHUNK 64   ///< Rays traced by a single task
+
+/**
+ * @brief Solves A x = b by the Gaussian elimination with partial pivoting,
+ *  A is n x n row major, both are overwritten
+ * @return Whether A is regular
+ */
+static bool solve_linear(double* A, double* b, double* x, int n)
+{
+    for (int c = 0; c < n; ++c)
+    {
+        int pivot = c;
+        for (int r = c + 1; r < n; ++r)
+            if (std::abs(A[r * n + c]) > std::abs(A[pivot * n + c]))
+                pivot = r;
+        if (A[pivot * n + c] == 0.0)
+            return false;
+
+        for (int k = 0; k < n; ++k)
+            std::swap(A[c * n + k], A[pivot * n + k]);
+        std::swap(b[c], b[pivot]);
+
+        for (int r = c + 1; r < n; ++r)
+        {
+            double f = A[r * n + c] / A[c * n + c];
+            for (int k = c; k < n; ++k)
+                A[r * n + k] -= f * A[c * n + k];
+            b[r] -= f * b[c];
+        }
+    }
+
+    for (int r = n - 1; r >= 0; --r)
+    {
+        double sum = b[r];
+        for (int k = r + 1; k < n; ++k)
+            sum -= A[r * n + k] * x[k];
+        x[r] = sum / A[r * n + r];
+    }
+    return true;
+}
+
+AnalyticSky::AnalyticSky()
+{
+    m_coefficients.fill(glm::vec3(0.0f));
+
+    m_sphereDirs.resize(ANALYTIC_SKY_RAYS);
+    for (int i = 0; i < ANALYTIC_SKY_RAYS; ++i)
+        m_sphereDirs[i] = fibonacci_direction(i, ANALYTIC_SKY_RAYS);
+}
+
+void AnalyticSky::terms(float mu, float nu, float g, float t[ANALYTIC_SKY_TERMS])
+{
+    mu = glm::max(mu, 0.0f);
+    const float h[5] = { 1.0f, std::exp(-2.0f * mu), std::exp(-8.0f * mu),
+                         std::exp(-30.0f * mu), std::exp(-120.0f * mu) };
+
+    float x = 1.0f + g * g - 2.0f * g * nu;
+    const float p[4] = { 1.0f, nu, nu * nu, (1.0f + nu * nu) / (x * std::sqrt(x)) };
+
+    for (int i = 0; i < 5; ++i)
+        for (int j = 0; j < 4; ++j)
+            t[4 * i + j] = h[i] * p[j];
+}
+
+void AnalyticSky::fit(const AtmosphereParams& p, const glm::vec3& viewPos,
+                      const glm::vec3& sunDir)
+{
+    const glm::vec3 up = glm::normalize(viewPos);
+    const glm::vec3 sun = glm::normalize(sunDir);
+    m_viewPos = viewPos;
+
+    // Below the horizon, the rays end at the ground hidden by the planet
+    float r = glm::length(viewPos);
+    m_horizonMu = -std::sqrt(glm::max(0.0f, 1.0f - p.R_e * p.R_e / (r * r)));
+
+    // Same orientation of the set to the zenith wherever the viewer is
+    glm::vec3 tangent = glm::abs(up.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) 
+                                              : glm::vec3(0.0f, 0.0f, 1.0f);
+    tangent = glm::normalize(glm::cross(up, tangent));
+    glm::vec3 bitangent = glm::cross(tangent, up);
+
+    m_dirs.clear();
+    for (const glm::vec3& d : m_sphereDirs)
+        if (d.y >= m_horizonMu)
+            m_dirs.push_back(tangent * d.x + up * d.y + bitangent * d.z);
+
+    // Denser around the sun, where the aureole changes the fastest
+    glm::vec3 t1 = glm::abs(sun.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) 
+                                          : glm::vec3(0.0f, 1.0f, 0.0f);
+    t1 = glm::normalize(glm::cross(sun, t1));
+    glm::vec3 t2 = glm::cross(sun, t1);
+    const float cosCone = std::cos(glm::radians(ANALYTIC_SKY_SUN_CONE));
+    for (int i = 0; i < ANALYTIC_SKY_SUN_RAYS; ++i)
+    {
+        glm::vec3 c = fibonacci_direction(i, ANALYTIC_SKY_SUN_RAYS, cosCone);
+        glm::vec3 d = t1 * c.x + sun * c.y + t2 * c.z;
+        if (glm::dot(d, up) >= m_horizonMu)
+            m_dirs.push_back(d);
+    }
+
+    // Reference radiance per unit intensity
+    ReferenceView view;
+    view.viewPos = viewPos;
+    view.sunDir = sun;
+    view.viewSamples = ANALYTIC_SKY_VIEW_SAMPLES;
+    view.lightSamples = ANALYTIC_SKY_LIGHT_SAMPLES;
+    AtmosphereParams unit = p;
+    unit.I_sun = 1.0f;
+
+    const int count = int(m_dirs.size());
+    m_radiance.resize(count);
+    parallel_for(0, (count + ANALYTIC_SKY_CHUNK - 1) / ANALYTIC_SKY_CHUNK, 
+                 [&](int chunk) {
+        int first = chunk * ANALYTIC_SKY_CHUNK;
+        reference_radiance(unit, view, &m_dirs[first],
+                           glm::min(ANALYTIC_SKY_CHUNK, count - first),
+                           &m_radiance[first]);
+    });
+
+    std::vector<std::array<float, ANALYTIC_SKY_TERMS>> t(count);
+    for (int i = 0; i < count; ++i)
+        terms(glm::dot(m_dirs[i], up) - m_horizonMu, glm::dot(m_dirs[i], sun), 
+              p.g, t[i].data());
+
+    // Normal equations of each channel, weighted to the relative error so
+    //  that the dim sky is not traded for the aureole
+    const int n = ANALYTIC_SKY_TERMS;
+    for (int c = 0; c < 3; ++c)
+    {
+        double mean = 0.0;
+        for (int i = 0; i < count; ++i)
+            mean += m_radiance[i][c];
+        mean = glm::max(mean / glm::max(count, 1), 1e-12);
+
+        double A[n * n] = {};
+        double b[n] = {};
+        for (int i = 0; i < count; ++i)
+        {
+            double w = 1.0 / (m_radiance[i][c] + 0.05 * mean);
+            w *= w;
+            for (int k = 0; k < n; ++k)
+            {
+                b[k] += w * t[i][k] * m_radiance[i][c];
+                for (int m = 0; m < n; ++m)
+                    A[k * n + m] += w * t[i][k] * t[i][m];
+            }
+        }
+
+        // Slight ridge, the terms are close to collinear with few rays
+        double trace = 0.0;
+        for (int k = 0; k < n; ++k)
+            trace += A[k * n + k];
+        for (int k = 0; k < n; ++k)
+            A[k * n + k] += 1e-7 * trace / n;
+
+        double x[n];
+        if (!solve_linear(A, b, x, n))
+            continue;
+        for (int k = 0; k < n; ++k)
+            m_coefficients[k][c] = float(x[k]);
+    }
+}
@@ -0,0 +1,82 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file analytic_sky.hpp
+ * @brief Closed-form sky fitted to the ray marched model
+ *********************************************************/
+
+#pragma once
+
+#include "atmosphere_model.hpp"
+
+#include <array>
+#include <vector>
+
+
+#define ANALYTIC_SKY_TERMS          20  ///< Horizon terms times sun terms
+#define ANALYTIC_SKY_RAYS           512 ///< Fibonacci directions over the sphere
+#define ANALYTIC_SKY_SUN_RAYS       64  ///< Extra directions around the sun
+#define ANALYTIC_SKY_SUN_CONE       25.0f   ///< Half angle of those [degrees]
+#define ANALYTIC_SKY_VIEW_SAMPLES   32  ///< Samples along each reference ray
+#define ANALYTIC_SKY_LIGHT_SAMPLES  8   ///< Samples along each light ray
+#define ANALYTIC_SKY_MAX_ALTITUDE   0.1f    ///< Of the atmosphere height, where
+                                            ///<  the fit is still within 8 %
+
+
+/**
+ * @brief Sky radiance around the viewer in closed form, in the spirit of
+ *  Preetham and Hosek-Wilkie, but linear in its coefficients so that
+ *  they are fitted by a single weighted least squares solve against 
+ *  a sparse set of rays traced by reference_radiance. Cheap enough to be
+ *  refitted whenever the atmosphere, the sun or the viewer change.
+ *
+ *  Radiance of each channel per unit intensity of the sun:
+ *      L(mu, nu) = sum_ij c[4i + j] * h_i(mu) * p_j(nu)
+ *      h = (1, exp(-2 mu), exp(-8 mu), exp(-30 mu), exp(-120 mu))  horizon
+ *      p = (1, nu, nu^2, (1 + nu^2) / (1 + g^2 - 2 g nu)^1.5)   sun
+ *  where mu is the cosine of the zenith angle above the horizon, i.e. 
+ *  minus horizonMu() and clamped to 0, and nu the cosine of the angle
+ *  to the sun. The terms are the ones of draw_atmosphere_analytic.frag.
+ *
+ *  Relative L1 error of the fit over the sky on the ground is about 1 %
+ *  with the sun above 5 degrees and 4 % at the sunset. The limb of the
+ *  planet seen from above is too thin for the horizon terms, the error
+ *  grows to 8 % at ANALYTIC_SKY_MAX_ALTITUDE.
+ */
+class AnalyticSky
+{
+public:
+    AnalyticSky();
+
+    /**
+     * @brief Traces the reference rays on the global ThreadPool and fits 
+     *  the coefficients, blocks until done. Safe to call from a pool task.
+     * @param p Properties of the atmosphere
+     * @param viewPos Position of the viewer, inside of the atmosphere
+     * @param sunDir Direction towards the sun
+     */
+    void fit(const AtmosphereParams& p, const glm::vec3& viewPos,
+             const glm::vec3& sunDir);
+
+    /** @return Coefficients of the last fit, see the class description */
+    const std::array<glm::vec3, ANALYTIC_SKY_TERMS>& coefficients() const
+    {
+        return m_coefficients;
+    }
+
+    /** @return Cosine of the zenith angle of the horizon of the last fit */
+    float horizonMu() const { return m_horizonMu; }
+
+    /** @return Position of the viewer of the last fit */
+    const glm::vec3& viewPos() const { return m_viewPos; }
+
+    /** @brief Terms of the model, see the class description */
+    static void terms(float mu, float nu, float g, float t[ANALYTIC_SKY_TERMS]);
+
+private:
+    std::vector<glm::vec3> m_sphereDirs;    ///< Fibonacci set, computed once
+    std::vector<glm::vec3> m_dirs;          ///< Reference rays of the fit
+    std::vector<glm::vec3> m_radiance;
+    std::array<glm::vec3, ANALYTIC_SKY_TERMS> m_coefficients;
+    float m_horizonMu = 0.0f;
+    glm::vec3 m_viewPos = glm::vec3(0.0f);
+};
@@ -0,0 +1,121 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file async_table.hpp
+ * @brief Double-buffered table rebuilt on the worker threads
+ *********************************************************/
+
+#pragma once
+
+#include "thread_pool.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <utility>
+
+
+/**
+ * @brief Holds two instances of a precomputed table. The front one is
+ *  complete and safe to read from the render thread, the back one is being
+ *  (re)built on the global ThreadPool. Finished builds are swapped in
+ *  from the render thread. Only one build runs at a time, requests made
+ *  meanwhile are coalesced into the next build with the latest inputs.
+ *
+ *  Usage example, once per frame on the render thread:
+ *      AsyncTable<TransmittanceLUT> lut;
+ *
+ *      AsyncTable<TransmittanceLUT>::Stamp built;
+ *      if (lut.swap_if_ready(built))
+ *          upload(lut.front());                // built from inputs 'built'
+ *
+ *      if (inputs_changed)
+ *          lut.start(inputs_version, [params](TransmittanceLUT& t) {
+ *              t.bake(params);                 // copy of the inputs
+ *          });
+ *
+ * @tparam Table Default constructible table
+ */
+template<typename Table>
+class AsyncTable
+{
+public:
+    using Stamp = uint64_t;
+
+    AsyncTable()
+      : m_front(std::make_unique<Table>()),
+        m_back(std::make_unique<Table>())
+    {
+    }
+
+    // The build references the back table
+    ~AsyncTable() { wait(); }
+
+    AsyncTable(const AsyncTable&) = delete;
+    AsyncTable& operator=(const AsyncTable&) = delete;
+
+    /**
+     * @brief Starts building the back table unless a build is in progress
+     * @param stamp Version of the inputs, returned by swap_if_ready
+     * @param build Callable filling the table passed to it, runs on a worker,
+     *              must own copies of its inputs
+     * @return Whether the build was started
+     */
+    template<typename Build>
+    bool start(Stamp stamp, Build build)
+    {
+        if (m_job.valid())
+            return false;
+
+        m_backStamp = stamp;
+        Table* back = m_back.get();
+        m_job = ThreadPool::global().submit([back, build]() {
+            build(*back);
+        });
+
+        return true;
+    }
+
+    /**
+     * @brief Swaps the tables when the build has finished, rethrows
+     *  an exception thrown by the build
+     * @param stamp Version of the inputs the new front table was built from
+     * @return Whether the front table changed
+     */
+    bool swap_if_ready(Stamp& stamp)
+    {
+        using namespace std::chrono_literals;
+
+        if (!m_job.valid() || m_job.wait_for(0s) != std::future_status::ready)
+            return false;
+
+        m_job.get();
+        std::swap(m_front, m_back);
+        m_ready = true;
+        stamp = m_backStamp;
+
+        return true;
+    }
+
+    /** @brief Blocks until the build in progress, if any, finishes */
+    void wait() const
+    {
+        if (m_job.valid())
+            m_job.wait();
+    }
+
+    /** @return Whether any build was swapped in, i.e., front is complete */
+    bool is_ready() const { return m_ready; }
+
+    bool is_building() const { return m_job.valid(); }
+
+    const Table& front() const { return *m_front; }
+
+private:
+    std::unique_ptr<Table> m_front;     ///< Complete table, read by the renderer
+    std::unique_ptr<Table> m_back;      ///< Table being built
+    Stamp m_backStamp = 0;              ///< Version of the inputs of the build
+    std::future<void> m_job;            ///< Build in progress, if valid
+    bool m_ready = false;
+};
+
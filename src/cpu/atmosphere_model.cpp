@@ -0,0 +1,77 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file atmosphere_model.cpp
+ * @brief CPU side model of the atmosphere, mirrors the
+ *        functions used in the shaders
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "atmosphere_model.hpp"
+
+
+glm::vec2 ray_sphere_intersection(const glm::vec3& o, const glm::vec3& d,
+                                  float r)
+{
+    // Solving analytically as a quadratic function
+    float a = glm::dot(d, d);
+    float b = 2.0f * glm::dot(d, o);
+    float c = glm::dot(o, o) - r * r;
+
+    float delta = b * b - 4.0f * a * c;
+
+    // Roots not found
+    if (delta < 0.0f)
+        return glm::vec2(1e5f, -1e5f);
+
+    float sqrtDelta = std::sqrt(delta);
+    return glm::vec2((-b - sqrtDelta) / (2.0f * a),
+                     (-b + sqrtDelta) / (2.0f * a));
+}
+
+glm::vec3 fibonacci_direction(int i, int count, float cosMax)
+{
+    const float goldenAngle = float(M_PI) * (3.0f - std::sqrt(5.0f));
+
+    float y = 1.0f - (i + 0.5f) / float(count) * (1.0f - cosMax);
+    float r = std::sqrt(glm::max(0.0f, 1.0f - y * y));
+    float phi = goldenAngle * float(i);
+    return glm::vec3(r * std::cos(phi), y, r * std::sin(phi));
+}
+
+glm::vec2 optical_depth(const AtmosphereParams& p, const glm::vec3& o,
+                        const glm::vec3& d, float len, int samples)
+{
+    float segmentLen = len / float(samples);
+    glm::vec2 optDepth(0.0f);
+
+    for (int i = 0; i < samples; ++i)
+    {
+        glm::vec3 sample = o + d * (segmentLen * (float(i) + 0.5f));
+        float height = glm::length(sample) - p.R_e;
+
+        optDepth.x += std::exp(-height / p.H_R) * segmentLen;
+        optDepth.y += std::exp(-height / p.H_M) * segmentLen;
+    }
+
+    return optDepth;
+}
+
+glm::vec3 extinction(const AtmosphereParams& p, const glm::vec2& optDepth)
+{
+    return glm::exp(-(p.beta_R * optDepth.x +
+                      p.beta_M * MIE_EXTINCTION_FACTOR * optDepth.y));
+}
+
+float phase_rayleigh(float mu)
+{
+    return 3.0f / (16.0f * float(M_PI)) * (1.0f + mu * mu);
+}
+
+float phase_mie(float g, float mu)
+{
+    float g_2 = g * g;
+    return 3.0f / (8.0f * float(M_PI)) * 
+           ((1.0f - g_2) * (1.0f + mu * mu)) /
+           ((2.0f + g_2) * std::pow(1.0f + g_2 - 2.0f * g * mu, 1.5f));
+}
+
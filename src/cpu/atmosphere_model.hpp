@@ -0,0 +1,88 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file atmosphere_model.hpp
+ * @brief CPU side model of the atmosphere, mirrors the
+ *        functions used in the shaders
+ *********************************************************/
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+
+// Mie extinction coefficient = 1.1 of the Mie scattering coefficient
+#define MIE_EXTINCTION_FACTOR 1.1f
+
+// Average reflectance of the ground, lit by the sun and the sky
+#define GROUND_ALBEDO 0.1f
+
+
+/**
+ * @brief Physical properties of an atmosphere, units as in the Atmosphere
+ *  class, i.e., distances in [km] and coefficients in [km^-1]
+ */
+struct AtmosphereParams
+{
+    float I_sun;            ///< Intensity of the sun
+    float R_e;              ///< Radius of the planet
+    float R_a;              ///< Radius of the atmosphere
+
+    glm::vec3 beta_R;       ///< Rayleigh scattering coefficient
+    float H_R;              ///< Rayleigh scale height
+
+    float beta_M;           ///< Mie scattering coefficient
+    float H_M;              ///< Mie scale height
+    float g;                ///< Mie scattering direction - anisotropy
+};
+
+/**
+ * @brief Computes intersection between a ray and a sphere centered at
+ *  the origin
+ * @param o Origin of the ray
+ * @param d Direction of the ray
+ * @param r Radius of the sphere
+ * @return Roots (near, far), or (1e5, -1e5) when the ray misses the sphere
+ */
+glm::vec2 ray_sphere_intersection(const glm::vec3& o, const glm::vec3& d,
+                                  float r);
+
+/**
+ * @brief Direction of an equal area Fibonacci spiral around +y, neighbours
+ *  along it are a golden angle apart
+ * @param i Index of the direction
+ * @param count Number of the directions
+ * @param cosMax Cosine of the half angle of the covered cap, -1 for
+ *               the whole sphere
+ */
+glm::vec3 fibonacci_direction(int i, int count, float cosMax = -1.0f);
+
+/**
+ * @brief Integrates Rayleigh and Mie optical depth along a ray segment
+ *  using the midpoint rule, the same way the shader does
+ * @param p Properties of the atmosphere
+ * @param o Origin of the segment
+ * @param d Direction of the segment, normalized
+ * @param len Length of the segment
+ * @param samples Number of samples along the segment
+ * @return Optical depth (Rayleigh, Mie)
+ */
+glm::vec2 optical_depth(const AtmosphereParams& p, const glm::vec3& o,
+                        const glm::vec3& d, float len, int samples);
+
+/**
+ * @brief Converts optical depth to transmittance for RGB wavelengths
+ * @param p Properties of the atmosphere
+ * @param optDepth Optical depth (Rayleigh, Mie)
+ */
+glm::vec3 extinction(const AtmosphereParams& p, const glm::vec2& optDepth);
+
+/** @brief Rayleigh phase function, mu is cosine of the scattering angle */
+float phase_rayleigh(float mu);
+
+/**
+ * @brief Mie phase function (Cornette-Shanks)
+ * @param g Anisotropy of the medium
+ * @param mu Cosine of the scattering angle
+ */
+float phase_mie(float g, float mu);
+
@@ -0,0 +1,125 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file ground_irradiance_lut.cpp
+ * @brief Precomputed irradiance of the sky on a horizontal
+ *        surface
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "ground_irradiance_lut.hpp"
+#include "parallel.hpp"
+
+
+GroundIrradianceLUT::GroundIrradianceLUT(int width, int height)
+  : m_params()
+{
+    m_table.resize(width, height);
+}
+
+void GroundIrradianceLUT::bake(const AtmosphereParams& p, 
+                               const TransmittanceLUT& transmittance,
+                               const MultipleScatteringLUT& multipleScattering)
+{
+    m_params = p;
+
+    const float H_a = p.R_a - p.R_e;
+    parallel_for(0, m_table.height, [&](int y) {
+        // Texel center lies exactly on the parameter y / (height - 1)
+        float v = float(y) / float(m_table.height - 1);
+        float r = p.R_e + v * v * H_a;
+
+        for (int x = 0; x < m_table.width; ++x)
+        {
+            float mu_s = float(x) / float(m_table.width - 1) * 2.0f - 1.0f;
+            m_table.at(x, y) = integrate(r, mu_s, transmittance, 
+                                         multipleScattering);
+        }
+    });
+}
+
+glm::vec3 GroundIrradianceLUT::lookup(float r, float mu_s) const
+{
+    float h = glm::clamp((r - m_params.R_e) / (m_params.R_a - m_params.R_e),
+                         0.0f, 1.0f);
+
+    return m_table.sample(to_texel_center(mu_s * 0.5f + 0.5f, m_table.width),
+                          to_texel_center(std::sqrt(h), m_table.height));
+}
+
+glm::vec3 GroundIrradianceLUT::integrate(float r, float mu_s,
+                        const TransmittanceLUT& transmittance,
+                        const MultipleScatteringLUT& multipleScattering) const
+{
+    const AtmosphereParams& p = m_params;
+
+    // Lifted as in MultipleScatteringLUT, the surface faces the zenith
+    glm::vec3 o(0.0f, glm::max(r, p.R_e + 1e-3f), 0.0f);
+    glm::vec3 sunDir(std::sqrt(glm::max(0.0f, 1.0f - mu_s * mu_s)), mu_s, 0.0f);
+
+    glm::vec3 E(0.0f);
+
+    // Equal area stratification of the upper hemisphere
+    const int n = GROUND_IRRADIANCE_DIRECTIONS;
+    for (int i = 0; i < n; ++i)
+    {
+        float cosTheta = 1.0f - (i + 0.5f) / float(n);
+        float sinTheta = std::sqrt(glm::max(0.0f, 1.0f - cosTheta * cosTheta));
+
+        for (int j = 0; j < n; ++j)
+        {
+            float phi = 2.0f * float(M_PI) * (j + 0.5f) / float(n);
+            glm::vec3 d(sinTheta * std::cos(phi), cosTheta, 
+                        sinTheta * std::sin(phi));
+
+            float nu = glm::dot(d, sunDir);
+            float phase_R = phase_rayleigh(nu);
+            float phase_M = phase_mie(p.g, nu);
+
+            // Segment inside of the atmosphere, ending at the ground when
+            //  looking down from an altitude
+            float tMax = ray_sphere_intersection(o, d, p.R_a).y;
+            glm::vec2 tGround = ray_sphere_intersection(o, d, p.R_e);
+            if (tGround.x > 0.0f && tGround.x < tMax)
+                tMax = tGround.x;
+
+            const int samples = GROUND_IRRADIANCE_SAMPLES;
+            float dt = tMax / float(samples);
+            glm::vec3 T(1.0f);      // Transmittance from the surface
+            glm::vec3 L(0.0f);
+
+            for (int s = 0; s < samples; ++s)
+            {
+                glm::vec3 x = o + d * ((s + 0.5f) * dt);
+                float r_x = glm::length(x);
+                float height = r_x - p.R_e;
+                float mu_x = glm::dot(x, sunDir) / r_x;
+
+                glm::vec3 scattering_R = p.beta_R * std::exp(-height / p.H_R);
+                float scattering_M = p.beta_M * std::exp(-height / p.H_M);
+                glm::vec3 extinct = scattering_R + 
+                                    glm::vec3(scattering_M * MIE_EXTINCTION_FACTOR);
+
+                glm::vec3 sampleT = glm::exp(-extinct * dt);
+                glm::vec3 sunT = transmittance.lookup(r_x, mu_x);
+                glm::vec3 psi_ms = multipleScattering.lookup(r_x, mu_x);
+
+                glm::vec3 S = sunT * (scattering_R * phase_R + 
+                                      glm::vec3(scattering_M * phase_M)) +
+                              psi_ms * (scattering_R + glm::vec3(scattering_M));
+
+                // Analytical integration over the segment, see
+                //  MultipleScatteringLUT::integrate
+                glm::vec3 integral = (glm::vec3(1.0f) - sampleT) / 
+                                     glm::max(extinct, glm::vec3(1e-9f));
+
+                L += T * S * integral;
+                T *= sampleT;
+            }
+
+            E += L * cosTheta;
+        }
+    }
+
+    // Each direction covers the solid angle 2 pi / n^2
+    return E * (2.0f * float(M_PI) / float(n * n));
+}
@@ -0,0 +1,77 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file ground_irradiance_lut.hpp
+ * @brief Precomputed irradiance of the sky on a horizontal
+ *        surface
+ *********************************************************/
+
+#pragma once
+
+#include "atmosphere_model.hpp"
+#include "multiple_scattering_lut.hpp"
+#include "transmittance_lut.hpp"
+#include "lut2d.hpp"
+
+
+#define GROUND_IRRADIANCE_LUT_WIDTH     64  ///< Resolution of cosine of sun zenith
+#define GROUND_IRRADIANCE_LUT_HEIGHT    16  ///< Resolution of altitude
+#define GROUND_IRRADIANCE_DIRECTIONS    8   ///< Directions along each axis
+                                            ///<  of the hemisphere, squared
+#define GROUND_IRRADIANCE_SAMPLES       24  ///< Samples along each ray
+
+
+/**
+ * @brief Table of irradiance of the sky on a horizontal surface, i.e. 
+ *  radiance of the upper hemisphere weighted by the cosine of the zenith
+ *  angle, without the direct sunlight and the intensity of the sun. 
+ *  Includes single scattering with both phase functions and the multiple
+ *  scattering approximation of MultipleScatteringLUT. Lights the ground
+ *  with a single lookup instead of integrating the hemisphere per pixel,
+ *  the direct sunlight is attenuated by TransmittanceLUT. Baked from 
+ *  the finished transmittance and multiple scattering tables.
+ *
+ *  Parametrization mirrors TransmittanceLUT:
+ *      u = mu_s * 0.5 + 0.5
+ *      v = sqrt(altitude / (R_a - R_e))
+ *  both mapped to texel centers.
+ */
+class GroundIrradianceLUT
+{
+public:
+    GroundIrradianceLUT(int width = GROUND_IRRADIANCE_LUT_WIDTH,
+                        int height = GROUND_IRRADIANCE_LUT_HEIGHT);
+
+    /**
+     * @brief (Re)computes the table on the global ThreadPool, blocks
+     *  until done. Safe to call from a pool task.
+     * @param p Properties of the atmosphere
+     * @param transmittance Table baked for the same properties
+     * @param multipleScattering Table baked for the same properties
+     */
+    void bake(const AtmosphereParams& p, const TransmittanceLUT& transmittance,
+              const MultipleScatteringLUT& multipleScattering);
+
+    /**
+     * @brief Irradiance of the sky, for the params last baked with
+     * @param r Distance of the surface from the center of the planet
+     * @param mu_s Cosine of the sun zenith angle at the surface
+     */
+    glm::vec3 lookup(float r, float mu_s) const;
+
+    const LUT2D& table() const { return m_table; }
+
+private:
+    /**
+     * @brief Integrates radiance of the sky over the upper hemisphere
+     * @param r Distance of the surface from the center of the planet
+     * @param mu_s Cosine of the sun zenith angle at the surface
+     * @param transmittance See bake
+     * @param multipleScattering See bake
+     */
+    glm::vec3 integrate(float r, float mu_s, const TransmittanceLUT& transmittance,
+                        const MultipleScatteringLUT& multipleScattering) const;
+
+private:
+    LUT2D m_table;
+    AtmosphereParams m_params;
+};
@@ -0,0 +1,115 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file image_compare.cpp
+ * @brief Difference metrics of rendered images
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "image_compare.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+
+/**
+ * @brief Converts tone mapped linear RGB with the sRGB primaries to CIE Lab
+ *  of the D65 white point
+ * @param rgb Packet of colors, overwritten by L, a, b
+ */
+static void rgb_to_lab(vfloat rgb[3])
+{
+    // XYZ divided by the white point
+    vfloat x = (rgb[0] * 0.4124f + rgb[1] * 0.3576f + rgb[2] * 0.1805f) * (1.0f / 0.95047f);
+    vfloat y =  rgb[0] * 0.2126f + rgb[1] * 0.7152f + rgb[2] * 0.0722f;
+    vfloat z = (rgb[0] * 0.0193f + rgb[1] * 0.1192f + rgb[2] * 0.9505f) * (1.0f / 1.08883f);
+
+    // Cube root with a linear segment close to black
+    vfloat f[3] = { x, y, z };
+    for (int c = 0; c < 3; ++c)
+        f[c] = select(f[c] > 0.008856f, cbrt_unit(f[c]), 
+                      f[c] * 7.787f + 16.0f / 116.0f);
+
+    rgb[0] = f[1] * 116.0f - 16.0f;
+    rgb[1] = (f[0] - f[1]) * 500.0f;
+    rgb[2] = (f[1] - f[2]) * 200.0f;
+}
+
+ImageDifference compare_images(const LUT2D& image, const LUT2D& reference)
+{
+    ImageDifference diff;
+    if (image.width != reference.width || image.height != reference.height ||
+        image.data.empty())
+        return diff;
+
+    // Sums of each row, reduced in a fixed order to be deterministic
+    struct RowSums
+    {
+        double deltaE, maxDeltaE, absError, reference;
+    };
+    std::vector<RowSums> rows(image.height);
+
+    parallel_for(0, image.height, [&](int y) {
+        alignas(32) float in[2][3][SIMD_WIDTH];
+        vfloat sumDeltaE = 0.0f, maxDeltaE = 0.0f;
+        vfloat absError = 0.0f, refSum = 0.0f;
+
+        for (int x = 0; x < image.width; x += SIMD_WIDTH)
+        {
+            // Lanes outside of the row repeat the same black pixel in both
+            //  images, adding nothing
+            int lanes = glm::min(SIMD_WIDTH, image.width - x);
+            for (int l = 0; l < SIMD_WIDTH; ++l)
+            {
+                glm::vec3 a(0.0f), b(0.0f);
+                if (l < lanes)
+                {
+                    a = image.at(x + l, y);
+                    b = reference.at(x + l, y);
+                }
+                for (int c = 0; c < 3; ++c)
+                {
+                    in[0][c][l] = a[c];
+                    in[1][c][l] = b[c];
+                }
+            }
+
+            vfloat lab[2][3];
+            for (int i = 0; i < 2; ++i)
+                for (int c = 0; c < 3; ++c)
+                {
+                    vfloat radiance = vfloat::load(in[i][c]);
+                    if (i == 0)
+                        absError += abs(radiance - vfloat::load(in[1][c]));
+                    else
+                        refSum += abs(radiance);
+
+                    // Same operator as toneMappingFactor in the shaders
+                    lab[i][c] = -exp(-max(radiance, 0.0f)) + 1.0f;
+                }
+            rgb_to_lab(lab[0]);
+            rgb_to_lab(lab[1]);
+
+            vfloat dL = lab[0][0] - lab[1][0];
+            vfloat da = lab[0][1] - lab[1][1];
+            vfloat db = lab[0][2] - lab[1][2];
+            vfloat deltaE = sqrt(dL * dL + da * da + db * db);
+            sumDeltaE += deltaE;
+            maxDeltaE = max(maxDeltaE, deltaE);
+        }
+
+        rows[y] = { reduce_add(sumDeltaE), reduce_max(maxDeltaE),
+                    reduce_add(absError), reduce_add(refSum) };
+    });
+
+    double absError = 0.0, refSum = 0.0;
+    for (const RowSums& row : rows)
+    {
+        diff.meanDeltaE += row.deltaE;
+        diff.maxDeltaE = glm::max(diff.maxDeltaE, row.maxDeltaE);
+        absError += row.absError;
+        refSum += row.reference;
+    }
+    diff.meanDeltaE /= double(image.width) * image.height;
+    diff.relativeError = refSum > 0.0 ? absError / refSum : absError;
+
+    return diff;
+}
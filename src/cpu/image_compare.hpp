@@ -0,0 +1,30 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file image_compare.hpp
+ * @brief Difference metrics of rendered images
+ *********************************************************/
+
+#pragma once
+
+#include "lut2d.hpp"
+
+
+/** @brief Difference of an image from a reference image */
+struct ImageDifference
+{
+    double meanDeltaE = 0.0;    ///< Mean CIE76 color difference, tone mapped
+    double maxDeltaE = 0.0;     ///< Largest color difference of a pixel
+    double relativeError = 0.0; ///< Sum of absolute radiance differences 
+                                ///  over the sum of the reference radiance
+};
+
+/**
+ * @brief Compares two images of radiance of the same size. The color 
+ *  difference is measured in CIE Lab of the tone mapped colors as they 
+ *  appear on the screen (see toneMappingFactor), the relative error of 
+ *  the radiance itself. Pixels are processed in SIMD packets, rows on
+ *  all the cores.
+ * @param image Tested image
+ * @param reference Reference image, e.g. by ReferenceRenderer
+ */
+ImageDifference compare_images(const LUT2D& image, const LUT2D& reference);
@@ -0,0 +1,66 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file lut2d.hpp
+ * @brief CPU side 2D lookup table of RGB values
+ *********************************************************/
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+
+/**
+ * @brief Maps a parameter in [0, 1] to texture coordinates of texel centers,
+ *  i.e., 0 maps to the center of the first texel, 1 to the center of the last
+ * @param x Parameter in [0, 1]
+ * @param n Number of texels
+ */
+inline float to_texel_center(float x, int n)
+{
+    return 0.5f / n + x * (1.0f - 1.0f / n);
+}
+
+/**
+ * @brief 2D table of RGB floats stored row by row, can be directly uploaded
+ *  to a texture using Texture2D::upload(const float*, ...).
+ *  Sampling mirrors GL_LINEAR filtering with GL_CLAMP_TO_EDGE wrapping.
+ */
+struct LUT2D
+{
+    int width = 0;
+    int height = 0;
+    std::vector<glm::vec3> data;
+
+    void resize(int w, int h)
+    {
+        width = w;
+        height = h;
+        data.assign(size_t(w) * h, glm::vec3(0.0f));
+    }
+
+    glm::vec3& at(int x, int y) { return data[size_t(y) * width + x]; }
+    const glm::vec3& at(int x, int y) const { return data[size_t(y) * width + x]; }
+
+    const float* ptr() const { return &data[0].x; }
+
+    /**
+     * @brief Bilinear sample of the table
+     * @param u Texture coordinate in [0, 1] along the width
+     * @param v Texture coordinate in [0, 1] along the height
+     */
+    glm::vec3 sample(float u, float v) const
+    {
+        float x = glm::clamp(u * width - 0.5f, 0.0f, float(width - 1));
+        float y = glm::clamp(v * height - 0.5f, 0.0f, float(height - 1));
+
+        int x0 = int(x), y0 = int(y);
+        int x1 = glm::min(x0 + 1, width - 1);
+        int y1 = glm::min(y0 + 1, height - 1);
+        float fx = x - x0, fy = y - y0;
+
+        return glm::mix(glm::mix(at(x0, y0), at(x1, y0), fx),
+                        glm::mix(at(x0, y1), at(x1, y1), fx), fy);
+    }
+};
+
@@ -0,0 +1,85 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file lut4d.hpp
+ * @brief CPU side 4D lookup table of RGB values packed
+ *        into a 3D texture layout
+ *********************************************************/
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+
+/**
+ * @brief 4D table of RGB floats indexed by (x, y, z, w). Stored in the layout
+ *  of a 3D texture of dimensions (w_size * x_size, y_size, z_size), i.e.,
+ *  the slices of w are placed side by side along the width. Can be directly
+ *  uploaded using Texture3D::upload(const float*, ...).
+ *
+ *  Sampling mirrors GL_LINEAR filtering of the 3D texture with
+ *  GL_CLAMP_TO_EDGE, and a manual linear interpolation between two slices
+ *  of w, as done in the shaders.
+ */
+struct LUT4D
+{
+    int xSize = 0, ySize = 0, zSize = 0, wSize = 0;
+    std::vector<glm::vec3> data;
+
+    void resize(int x, int y, int z, int w)
+    {
+        xSize = x; ySize = y; zSize = z; wSize = w;
+        data.assign(size_t(x) * y * z * w, glm::vec3(0.0f));
+    }
+
+    int width() const { return wSize * xSize; }
+    int height() const { return ySize; }
+    int depth() const { return zSize; }
+
+    glm::vec3& at(int x, int y, int z, int w)
+    {
+        return data[(size_t(z) * ySize + y) * width() + w * xSize + x];
+    }
+    const glm::vec3& at(int x, int y, int z, int w) const
+    {
+        return data[(size_t(z) * ySize + y) * width() + w * xSize + x];
+    }
+
+    const float* ptr() const { return &data[0].x; }
+
+    /**
+     * @brief Quadrilinear sample of the table
+     * @param u, v, s Texture coordinates in [0, 1] of x, y and z
+     * @param t Coordinate in [0, 1] of w, slices lie on t * (wSize - 1)
+     */
+    glm::vec3 sample(float u, float v, float s, float t) const
+    {
+        float fw = glm::clamp(t, 0.0f, 1.0f) * (wSize - 1);
+        int w0 = int(fw);
+        int w1 = glm::min(w0 + 1, wSize - 1);
+
+        return glm::mix(sample_slice(u, v, s, w0), sample_slice(u, v, s, w1),
+                        fw - w0);
+    }
+
+private:
+    glm::vec3 sample_slice(float u, float v, float s, int w) const
+    {
+        float x = glm::clamp(u * xSize - 0.5f, 0.0f, float(xSize - 1));
+        float y = glm::clamp(v * ySize - 0.5f, 0.0f, float(ySize - 1));
+        float z = glm::clamp(s * zSize - 0.5f, 0.0f, float(zSize - 1));
+
+        int x0 = int(x), y0 = int(y), z0 = int(z);
+        int x1 = glm::min(x0 + 1, xSize - 1);
+        int y1 = glm::min(y0 + 1, ySize - 1);
+        int z1 = glm::min(z0 + 1, zSize - 1);
+        float fx = x - x0, fy = y - y0, fz = z - z0;
+
+        glm::vec3 c0 = glm::mix(glm::mix(at(x0, y0, z0, w), at(x1, y0, z0, w), fx),
+                                glm::mix(at(x0, y1, z0, w), at(x1, y1, z0, w), fx), fy);
+        glm::vec3 c1 = glm::mix(glm::mix(at(x0, y0, z1, w), at(x1, y0, z1, w), fx),
+                                glm::mix(at(x0, y1, z1, w), at(x1, y1, z1, w), fx), fy);
+        return glm::mix(c0, c1, fz);
+    }
+};
+
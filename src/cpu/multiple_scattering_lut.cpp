@@ -0,0 +1,135 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file multiple_scattering_lut.cpp
+ * @brief Approximation of multiple scattering of any order
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "multiple_scattering_lut.hpp"
+#include "parallel.hpp"
+
+
+MultipleScatteringLUT::MultipleScatteringLUT(int size)
+  : m_params()
+{
+    m_table.resize(size, size);
+}
+
+void MultipleScatteringLUT::bake(const AtmosphereParams& p)
+{
+    m_params = p;
+    m_transmittance.bake(p);
+
+    const float H_a = p.R_a - p.R_e;
+    parallel_for(0, m_table.height, [&](int y) {
+        // Texel center lies exactly on the parameter y / (height - 1)
+        float v = float(y) / float(m_table.height - 1);
+        float r = p.R_e + v * v * H_a;
+
+        for (int x = 0; x < m_table.width; ++x)
+        {
+            float mu_s = float(x) / float(m_table.width - 1) * 2.0f - 1.0f;
+            m_table.at(x, y) = integrate(r, mu_s);
+        }
+    });
+}
+
+glm::vec3 MultipleScatteringLUT::lookup(float r, float mu_s) const
+{
+    float h = glm::clamp((r - m_params.R_e) / (m_params.R_a - m_params.R_e),
+                         0.0f, 1.0f);
+
+    return m_table.sample(to_texel_center(mu_s * 0.5f + 0.5f, m_table.width),
+                          to_texel_center(std::sqrt(h), m_table.height));
+}
+
+glm::vec3 MultipleScatteringLUT::integrate(float r, float mu_s) const
+{
+    const AtmosphereParams& p = m_params;
+    const float phase_uniform = 1.0f / (4.0f * float(M_PI));
+
+    // Lift the point slightly so that rays along the horizon do not
+    //  immediately hit the ground
+    glm::vec3 o(0.0f, glm::max(r, p.R_e + 1e-3f), 0.0f);
+    glm::vec3 sunDir(std::sqrt(glm::max(0.0f, 1.0f - mu_s * mu_s)), mu_s, 0.0f);
+
+    glm::vec3 L_2(0.0f);     // Second order radiance
+    glm::vec3 f_ms(0.0f);    // Transfer function of multiple scattering
+
+    // Equal area stratification of the sphere of directions
+    const int n = MULTIPLE_SCATTERING_DIRECTIONS;
+    for (int i = 0; i < n; ++i)
+    {
+        float cosTheta = 1.0f - 2.0f * (i + 0.5f) / float(n);
+        float sinTheta = std::sqrt(glm::max(0.0f, 1.0f - cosTheta * cosTheta));
+
+        for (int j = 0; j < n; ++j)
+        {
+            float phi = 2.0f * float(M_PI) * (j + 0.5f) / float(n);
+            glm::vec3 d(sinTheta * std::cos(phi), cosTheta, 
+                        sinTheta * std::sin(phi));
+
+            // Segment inside of the atmosphere, ending at the ground
+            float tMax = ray_sphere_intersection(o, d, p.R_a).y;
+            glm::vec2 tGround = ray_sphere_intersection(o, d, p.R_e);
+            bool hitsGround = tGround.x > 0.0f && tGround.x < tMax;
+            if (hitsGround)
+                tMax = tGround.x;
+
+            const int samples = MULTIPLE_SCATTERING_SAMPLES;
+            float dt = tMax / float(samples);
+            glm::vec3 T(1.0f);      // Transmittance from the point
+            glm::vec3 L(0.0f);
+            glm::vec3 f(0.0f);
+
+            for (int s = 0; s < samples; ++s)
+            {
+                glm::vec3 x = o + d * ((s + 0.5f) * dt);
+                float r_x = glm::length(x);
+                float height = r_x - p.R_e;
+
+                glm::vec3 scattering = p.beta_R * std::exp(-height / p.H_R) +
+                                       glm::vec3(p.beta_M * std::exp(-height / p.H_M));
+                glm::vec3 extinct = p.beta_R * std::exp(-height / p.H_R) +
+                                    glm::vec3(p.beta_M * MIE_EXTINCTION_FACTOR *
+                                              std::exp(-height / p.H_M));
+
+                glm::vec3 sampleT = glm::exp(-extinct * dt);
+                glm::vec3 sunT = m_transmittance.lookup(r_x, 
+                                                        glm::dot(x, sunDir) / r_x);
+
+                // Analytical integration over the segment, 
+                //  int_0^dt exp(-extinct * t) dt = (1 - sampleT) / extinct
+                glm::vec3 integral = (glm::vec3(1.0f) - sampleT) / 
+                                     glm::max(extinct, glm::vec3(1e-9f));
+
+                L += T * scattering * phase_uniform * sunT * integral;
+                f += T * scattering * integral;
+
+                T *= sampleT;
+            }
+
+            // Sunlight reflected by the ground, assumed to be lambertian
+            if (hitsGround)
+            {
+                glm::vec3 g = o + d * tMax;
+                float mu_ground = glm::dot(g, sunDir) / p.R_e;
+                glm::vec3 sunT = m_transmittance.lookup(p.R_e, mu_ground);
+                L += T * sunT * glm::max(mu_ground, 0.0f) * 
+                     (GROUND_ALBEDO / float(M_PI));
+            }
+
+            L_2 += L;
+            f_ms += f;
+        }
+    }
+
+    // Uniform weight of each direction, integrated with an isotropic phase
+    float weight = 1.0f / float(n * n);
+    L_2 *= weight;
+    f_ms *= weight;
+
+    // Sum of the geometric series of scattering orders
+    return L_2 / (glm::vec3(1.0f) - glm::min(f_ms, glm::vec3(0.99f)));
+}
+
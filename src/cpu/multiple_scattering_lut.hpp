@@ -0,0 +1,72 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file multiple_scattering_lut.hpp
+ * @brief Approximation of multiple scattering of any order
+ *********************************************************/
+
+#pragma once
+
+#include "atmosphere_model.hpp"
+#include "transmittance_lut.hpp"
+#include "lut2d.hpp"
+
+
+#define MULTIPLE_SCATTERING_LUT_SIZE    32  ///< Resolution of both axes
+#define MULTIPLE_SCATTERING_DIRECTIONS  8   ///< Directions along each axis
+                                            ///<  of the sphere, squared
+#define MULTIPLE_SCATTERING_SAMPLES     20  ///< Samples along each ray
+
+
+/**
+ * @brief Table of isotropic multiple scattering (second and higher orders)
+ *  after Hillaire, "A Scalable and Production Ready Sky and Atmosphere 
+ *  Rendering Technique", 2020. Light scattered twice or more is assumed 
+ *  isotropic and coming from the same neighbourhood, which reduces the 
+ *  infinite series of orders to a geometric one:
+ *      Psi_ms = L_2 / (1 - f_ms)
+ *  where L_2 is the second order radiance and f_ms the fraction of light 
+ *  scattered back towards the point. Multiplied by the scattering 
+ *  coefficient at a view sample it adds the missing energy, without the 
+ *  intensity of the sun.
+ *
+ *  Parametrization mirrors TransmittanceLUT:
+ *      u = mu_s * 0.5 + 0.5
+ *      v = sqrt(altitude / (R_a - R_e))
+ *  both mapped to texel centers.
+ */
+class MultipleScatteringLUT
+{
+public:
+    MultipleScatteringLUT(int size = MULTIPLE_SCATTERING_LUT_SIZE);
+
+    /**
+     * @brief (Re)computes the table on the global ThreadPool, blocks
+     *  until done. Safe to call from a pool task.
+     * @param p Properties of the atmosphere
+     */
+    void bake(const AtmosphereParams& p);
+
+    /**
+     * @brief Multiple scattering transfer, for the params last baked with
+     * @param r Distance of the point from the center of the planet
+     * @param mu_s Cosine of the sun zenith angle at the point
+     */
+    glm::vec3 lookup(float r, float mu_s) const;
+
+    const LUT2D& table() const { return m_table; }
+
+private:
+    /**
+     * @brief Integrates second order radiance and the transfer function 
+     *  over the sphere of directions around a point
+     * @param r Distance of the point from the center of the planet
+     * @param mu_s Cosine of the sun zenith angle at the point
+     */
+    glm::vec3 integrate(float r, float mu_s) const;
+
+private:
+    LUT2D m_table;
+    TransmittanceLUT m_transmittance;   ///< Own copy, baked alongside
+    AtmosphereParams m_params;
+};
+
@@ -0,0 +1,68 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file parallel.hpp
+ * @brief Splitting of CPU work across all cores
+ *********************************************************/
+
+#pragma once
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+
+/**
+ * @brief Calls fn(i) for every i in [begin, end) on the workers of the 
+ *  global ThreadPool and the calling thread. Returns after all the calls 
+ *  have finished. The caller takes part in the work and never waits for 
+ *  queued tasks to start, hence it is safe to call from a pool task.
+ * @param fn Callable taking an int, must be safe to call concurrently
+ */
+template<typename Fn>
+void parallel_for(int begin, int end, Fn&& fn)
+{
+    if (begin >= end)
+        return;
+
+    // Outlives the call, helpers may start after all the work is done
+    struct State
+    {
+        std::atomic<int> next;
+        std::atomic<int> done;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto state = std::make_shared<State>();
+    state->next = begin;
+    state->done = 0;
+    const int count = end - begin;
+
+    auto worker = [state, &fn, end, count]() {
+        for (int i = state->next++; i < end; i = state->next++)
+        {
+            fn(i);
+            if (++state->done == count)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    ThreadPool& pool = ThreadPool::global();
+    int helpers = std::min<int>(pool.size(), count - 1);
+    for (int t = 0; t < helpers; ++t)
+        pool.submit(worker);
+
+    worker();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state, count]() { 
+        return state->done == count; 
+    });
+}
+
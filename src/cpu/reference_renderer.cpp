@@ -0,0 +1,276 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file reference_renderer.cpp
+ * @brief Multithreaded SIMD ray marcher of the sky on the CPU
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "reference_renderer.hpp"
+#include "parallel.hpp"
+#include "simd.hpp"
+
+#include <chrono>
+
+
+/**
+ * @brief Intersection of rays with a sphere centered at the origin,
+ *  mirrors raySphereIntersection for normalized directions
+ * @param o Origins of the rays
+ * @param d Normalized directions of the rays
+ * @param r Radius of the sphere
+ * @param t0 Near roots, 1e5 where the ray misses the sphere
+ * @param t1 Far roots, -1e5 where the ray misses the sphere
+ */
+static void ray_sphere_intersection(const vvec3& o, const vvec3& d, float r,
+                                    vfloat& t0, vfloat& t1)
+{
+    // Both terms factored to avoid cancellation close to the sphere, where
+    //  the GPU version loses the ground in front of a viewer standing on it
+    vfloat lenO = length(o);
+    vfloat b = dot(d, o);
+    vfloat c = (lenO - r) * (lenO + r);
+    vfloat delta = b * b - c;
+
+    // Root of the larger magnitude first, the other one from Vieta's formula
+    vfloat sqrtDelta = sqrt(max(delta, 0.0f));
+    vfloat q = select(b < 0.0f, sqrtDelta - b, -b - sqrtDelta);
+    vfloat qOther = c / q;
+
+    vmask miss = delta < 0.0f;
+    t0 = select(miss, 1e5f, min(q, qOther));
+    t1 = select(miss, -1e5f, max(q, qOther));
+}
+
+/**
+ * @brief Integrates single scattering along a packet of view rays,
+ *  mirrors computeSkyColor with light rays marched
+ * @param p Properties of the atmosphere
+ * @param view Camera and sampling
+ * @param d Normalized directions of the view rays
+ * @param color In-scattered light towards the viewer, converted to RGB
+ *              in the spectral mode
+ */
+static void compute_sky_color(const AtmosphereParams& p, const ReferenceView& view,
+                              const vvec3& d, vfloat color[3])
+{
+    const vvec3 o(view.viewPos.x, view.viewPos.y, view.viewPos.z);
+    const glm::vec3 s = glm::normalize(view.sunDir);
+    const vvec3 sunDir(s.x, s.y, s.z);
+    const float beta_M_ext = p.beta_M * MIE_EXTINCTION_FACTOR;
+
+    // Rayleigh scattering of each channel, RGB or wavelength bins
+    float beta_R[SPECTRAL_BINS];
+    int channels = 3;
+    if (view.spectral)
+    {
+        rayleigh_spectrum(p.beta_R, beta_R);
+        channels = SPECTRAL_BINS;
+    }
+    else
+    {
+        for (int c = 0; c < 3; ++c)
+            beta_R[c] = p.beta_R[c];
+    }
+
+    vfloat t0, t1;
+    ray_sphere_intersection(o, d, p.R_a, t0, t1);
+    // Intersects behind
+    vmask miss = (t0 > t1) | (t1 < 0.0f);
+
+    // Start at the viewer when inside of the atmosphere, stop at the ground
+    t0 = max(t0, 0.0f);
+    vfloat tGround, tGroundFar;
+    ray_sphere_intersection(o, d, p.R_e, tGround, tGroundFar);
+    t1 = select(tGround > 0.0f, min(t1, tGround), t1);
+    t1 = max(t1, t0);
+
+    vfloat segmentLen = (t1 - t0) / float(view.viewSamples);
+
+    vfloat sum_R[SPECTRAL_BINS];
+    vfloat sum_M[SPECTRAL_BINS];
+    for (int c = 0; c < channels; ++c)
+        sum_R[c] = sum_M[c] = 0.0f;
+    vfloat optDepth_R = 0.0f;
+    vfloat optDepth_M = 0.0f;
+
+    // Sample along the view ray
+    for (int i = 0; i < view.viewSamples; ++i)
+    {
+        vfloat tCurrent = t0 + segmentLen * (float(i) + 0.5f);
+        vvec3 vSample = o + d * tCurrent;
+        vfloat r = length(vSample);
+        vfloat height = r - p.R_e;
+
+        vfloat h_R = exp(-height / p.H_R) * segmentLen;
+        vfloat h_M = exp(-height / p.H_M) * segmentLen;
+        optDepth_R += h_R;
+        optDepth_M += h_M;
+
+        // In the shadow of the planet, single scattering does not contribute
+        vfloat mu_s = dot(vSample, sunDir) / r;
+        vmask lit = (mu_s > 0.0f) |
+                    (r * r * (mu_s * mu_s - 1.0f) + p.R_e * p.R_e < 0.0f);
+        if (!any(lit))
+            continue;
+
+        //--------------------------------
+        // Secondary - light ray
+        vfloat tLight0, tLight1;
+        ray_sphere_intersection(vSample, sunDir, p.R_a, tLight0, tLight1);
+        vfloat segmentLenLight = tLight1 / float(view.lightSamples);
+
+        vfloat optDepthLight_R = 0.0f;
+        vfloat optDepthLight_M = 0.0f;
+        for (int j = 0; j < view.lightSamples; ++j)
+        {
+            vvec3 lSample = vSample + sunDir * (segmentLenLight * (float(j) + 0.5f));
+            vfloat heightLight = length(lSample) - p.R_e;
+
+            optDepthLight_R += exp(-heightLight / p.H_R);
+            optDepthLight_M += exp(-heightLight / p.H_M);
+        }
+        optDepthLight_R = (optDepthLight_R * segmentLenLight) + optDepth_R;
+        optDepthLight_M = (optDepthLight_M * segmentLenLight) + optDepth_M;
+
+        // Attenuation along the view ray and the light ray
+        for (int c = 0; c < channels; ++c)
+        {
+            vfloat att = exp(-(optDepthLight_R * beta_R[c] +
+                               optDepthLight_M * beta_M_ext));
+            sum_R[c] += select(lit, h_R * att, 0.0f);
+            sum_M[c] += select(lit, h_M * att, 0.0f);
+        }
+    }
+
+    //--------------------------------
+    // Rayleigh and Mie Phase functions
+    vfloat mu = dot(d, sunDir);
+    vfloat mu_2 = mu * mu;
+    vfloat phase_R = (mu_2 + 1.0f) * (3.0f / (16.0f * float(M_PI)));
+
+    float g_2 = p.g * p.g;
+    vfloat x = -mu * (2.0f * p.g) + (1.0f + g_2);
+    vfloat phase_M = (mu_2 + 1.0f) *
+                     (3.0f / (8.0f * float(M_PI)) * (1.0f - g_2) / (2.0f + g_2)) /
+                     (x * sqrt(x));
+
+    vfloat radiance[SPECTRAL_BINS];
+    for (int c = 0; c < channels; ++c)
+        radiance[c] = (sum_R[c] * phase_R * beta_R[c] +
+                       sum_M[c] * phase_M * p.beta_M) * p.I_sun;
+
+    if (view.spectral)
+    {
+        const auto& toRgb = spectral_to_rgb();
+        for (int c = 0; c < 3; ++c)
+        {
+            color[c] = 0.0f;
+            for (int bin = 0; bin < SPECTRAL_BINS; ++bin)
+                color[c] += radiance[bin] * toRgb[bin][c];
+        }
+    }
+    else
+    {
+        for (int c = 0; c < 3; ++c)
+            color[c] = radiance[c];
+    }
+
+    for (int c = 0; c < 3; ++c)
+        color[c] = select(miss, 0.0f, color[c]);
+}
+
+void reference_radiance(const AtmosphereParams& p, const ReferenceView& view,
+                        const glm::vec3* dirs, int count, glm::vec3* radiance)
+{
+    alignas(32) float d[3][SIMD_WIDTH];
+    alignas(32) float rgb[3][SIMD_WIDTH];
+
+    for (int i = 0; i < count; i += SIMD_WIDTH)
+    {
+        // The last packet repeats its last ray, as in render_tile
+        int lanes = glm::min(SIMD_WIDTH, count - i);
+        for (int l = 0; l < SIMD_WIDTH; ++l)
+            for (int c = 0; c < 3; ++c)
+                d[c][l] = dirs[i + glm::min(l, lanes - 1)][c];
+
+        vfloat color[3];
+        compute_sky_color(p, view, vvec3(vfloat::load(d[0]), vfloat::load(d[1]),
+                                         vfloat::load(d[2])), color);
+
+        for (int c = 0; c < 3; ++c)
+            color[c].store(rgb[c]);
+        for (int l = 0; l < lanes; ++l)
+            radiance[i + l] = glm::vec3(rgb[0][l], rgb[1][l], rgb[2][l]);
+    }
+}
+
+void ReferenceRenderer::render(const AtmosphereParams& p, const ReferenceView& view,
+                               int width, int height)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    if (m_image.width != width || m_image.height != height)
+        m_image.resize(width, height);
+
+    glm::mat4 invProj = glm::inverse(view.proj);
+    glm::mat3 invView = glm::transpose(glm::mat3(view.view));
+
+    int tilesX = (width + REFERENCE_TILE_SIZE - 1) / REFERENCE_TILE_SIZE;
+    int tilesY = (height + REFERENCE_TILE_SIZE - 1) / REFERENCE_TILE_SIZE;
+    parallel_for(0, tilesX * tilesY, [&](int tile) {
+        render_tile(p, view, invProj, invView, (tile % tilesX) * REFERENCE_TILE_SIZE,
+                    (tile / tilesX) * REFERENCE_TILE_SIZE);
+    });
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    m_renderTime = elapsed.count();
+}
+
+void ReferenceRenderer::render_tile(const AtmosphereParams& p,
+                                    const ReferenceView& view,
+                                    const glm::mat4& invProj,
+                                    const glm::mat3& invView, int x0, int y0)
+{
+    const int x1 = glm::min(x0 + REFERENCE_TILE_SIZE, m_image.width);
+    const int y1 = glm::min(y0 + REFERENCE_TILE_SIZE, m_image.height);
+
+    alignas(32) float dirs[3][SIMD_WIDTH];
+    alignas(32) float rgb[3][SIMD_WIDTH];
+
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int x = x0; x < x1; x += SIMD_WIDTH)
+        {
+            // Packet of pixels along the row, the last one of the tile
+            //  may be partially outside and repeats its last pixel
+            int lanes = glm::min(SIMD_WIDTH, x1 - x);
+            for (int l = 0; l < SIMD_WIDTH; ++l)
+            {
+                int px = x + glm::min(l, lanes - 1);
+                glm::vec2 ndc((px + 0.5f) / m_image.width * 2.0f - 1.0f,
+                              (y + 0.5f) / m_image.height * 2.0f - 1.0f);
+
+                // Direction towards the near plane in the view space, 
+                //  rotated to the world, independent of the camera position
+                //  and well conditioned for distant far planes
+                glm::vec4 nearPoint = invProj * glm::vec4(ndc, -1.0f, 1.0f);
+                glm::vec3 dir = glm::normalize(invView * (glm::vec3(nearPoint) / 
+                                                          nearPoint.w));
+
+                dirs[0][l] = dir.x;
+                dirs[1][l] = dir.y;
+                dirs[2][l] = dir.z;
+            }
+
+            vvec3 d(vfloat::load(dirs[0]), vfloat::load(dirs[1]),
+                    vfloat::load(dirs[2]));
+            vfloat color[3];
+            compute_sky_color(p, view, d, color);
+
+            for (int c = 0; c < 3; ++c)
+                color[c].store(rgb[c]);
+            for (int l = 0; l < lanes; ++l)
+                m_image.at(x + l, y) = glm::vec3(rgb[0][l], rgb[1][l], rgb[2][l]);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file reference_renderer.hpp
+ * @brief Multithreaded SIMD ray marcher of the sky on the CPU
+ *********************************************************/
+
+#pragma once
+
+#include "atmosphere_model.hpp"
+#include "lut2d.hpp"
+#include "spectrum.hpp"
+
+
+#define REFERENCE_TILE_SIZE 32  ///< Tiles of pixels distributed to the threads
+
+
+/**
+ * @brief Camera and sampling of a reference render, taken from the
+ *  Atmosphere class, see Atmosphere::get_referenceView
+ */
+struct ReferenceView
+{
+    glm::vec3 viewPos;      ///< Position of the viewer
+    glm::mat4 proj;         ///< Projection matrix of the camera
+    glm::mat4 view;         ///< View matrix of the camera
+    glm::vec3 sunDir;       ///< Direction towards the sun
+    int viewSamples;        ///< Samples along each view ray
+    int lightSamples;       ///< Samples along each light ray
+    bool spectral = false;  ///< Integrates SPECTRAL_BINS wavelengths, not RGB
+};
+
+/**
+ * @brief Radiance of the sky along arbitrary view rays, the integrator of
+ *  ReferenceRenderer traced in SIMD packets on the calling thread. The
+ *  camera matrices of the view are not used.
+ * @param p Properties of the atmosphere
+ * @param view Position of the viewer, the sun and sampling
+ * @param dirs Normalized directions of the rays
+ * @param count Number of the rays
+ * @param radiance Radiance towards the viewer along each ray
+ */
+void reference_radiance(const AtmosphereParams& p, const ReferenceView& view,
+                        const glm::vec3* dirs, int count, glm::vec3* radiance);
+
+/**
+ * @brief Renders single scattering of the sky the same way computeSkyColor
+ *  and raySphereIntersection in the ray marching shader do with light rays
+ *  marched, without the approximations of the interactive path. Serves as
+ *  the ground truth and as the offline path without a GPU.
+ *
+ *  Rays are traced in packets of SIMD_WIDTH neighbouring pixels (see simd.hpp),
+ *  the image is split into tiles processed on all the cores. In the spectral
+ *  mode, only the attenuation is evaluated per wavelength, the densities and
+ *  the light rays are shared by all the bins.
+ */
+class ReferenceRenderer
+{
+public:
+    ReferenceRenderer() = default;
+
+    /**
+     * @brief Renders the image of the sky, radiance without tone mapping
+     * @param p Properties of the atmosphere
+     * @param view Camera and sampling
+     * @param width Width of the image in pixels
+     * @param height Height of the image in pixels
+     */
+    void render(const AtmosphereParams& p, const ReferenceView& view,
+                int width, int height);
+
+    /** @return Image of the last render, the first row is at the bottom */
+    const LUT2D& image() const { return m_image; }
+
+    /** @return Duration of the last render in seconds */
+    double render_time() const { return m_renderTime; }
+
+private:
+    LUT2D m_image;
+    double m_renderTime = 0.0;
+
+    /** @brief Renders a tile of the image, at most tile size wide and high */
+    void render_tile(const AtmosphereParams& p, const ReferenceView& view,
+                     const glm::mat4& invProj, const glm::mat3& invView,
+                     int x0, int y0);
+};
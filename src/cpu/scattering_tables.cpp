@@ -0,0 +1,509 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file scattering_tables.cpp
+ * @brief Precomputed single and multiple scattering,
+ *        based on Bruneton and Neyret
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "scattering_tables.hpp"
+#include "parallel.hpp"
+
+#include <chrono>
+
+
+// Lowest cosine of the sun zenith stored in the table, sun below does not
+//  contribute noticeably, mirrored in draw_atmosphere_precomputed.frag
+#define MU_S_MIN (-0.2f)
+
+// ----------------------------------------------------------------------------
+// Geometry of rays in the atmosphere
+// ----------------------------------------------------------------------------
+static float safe_sqrt(float x) { return std::sqrt(glm::max(x, 0.0f)); }
+
+static bool ray_intersects_ground(const AtmosphereParams& p, float r, float mu)
+{
+    return mu < 0.0f && r * r * (mu * mu - 1.0f) + p.R_e * p.R_e >= 0.0f;
+}
+
+static float distance_to_top(const AtmosphereParams& p, float r, float mu)
+{
+    return glm::max(0.0f, -r * mu + safe_sqrt(r * r * (mu * mu - 1.0f) + p.R_a * p.R_a));
+}
+
+static float distance_to_bottom(const AtmosphereParams& p, float r, float mu)
+{
+    return glm::max(0.0f, -r * mu - safe_sqrt(r * r * (mu * mu - 1.0f) + p.R_e * p.R_e));
+}
+
+static float distance_to_boundary(const AtmosphereParams& p, float r, float mu,
+                                  bool rayGround)
+{
+    return rayGround ? distance_to_bottom(p, r, mu) : distance_to_top(p, r, mu);
+}
+
+static float density_rayleigh(const AtmosphereParams& p, float r)
+{
+    return std::exp(-(r - p.R_e) / p.H_R);
+}
+
+static float density_mie(const AtmosphereParams& p, float r)
+{
+    return std::exp(-(r - p.R_e) / p.H_M);
+}
+
+// Trapezoidal rule weight of the i-th of n + 1 samples
+static float trapezoid_weight(int i, int n)
+{
+    return (i == 0 || i == n) ? 0.5f : 1.0f;
+}
+
+// ----------------------------------------------------------------------------
+// Parametrization
+// ----------------------------------------------------------------------------
+static float mu_s_to_unit(float mu_s)
+{
+    return glm::max((1.0f - std::exp(-3.0f * (mu_s - MU_S_MIN))) /
+                    (1.0f - std::exp(-3.0f * (1.0f - MU_S_MIN))), 0.0f);
+}
+
+static float unit_to_mu_s(float x)
+{
+    return MU_S_MIN - 
+           std::log(1.0f - x * (1.0f - std::exp(-3.0f * (1.0f - MU_S_MIN)))) / 3.0f;
+}
+
+glm::vec4 ScatteringTables::to_uvwz(float r, float mu, float mu_s, float nu,
+                                    bool rayGround) const
+{
+    const AtmosphereParams& p = m_params;
+    const float H = safe_sqrt(p.R_a * p.R_a - p.R_e * p.R_e);
+    const float rho = safe_sqrt(r * r - p.R_e * p.R_e);
+    const int halfMu = m_scattering.ySize / 2;
+
+    float u_r = to_texel_center(glm::clamp(rho / H, 0.0f, 1.0f), m_scattering.zSize);
+
+    // Distance to the boundary, mapped separately for rays hitting the ground
+    float r_mu = r * mu;
+    float discriminant = r_mu * r_mu - r * r + p.R_e * p.R_e;
+    float u_mu;
+    if (rayGround)
+    {
+        float d = -r_mu - safe_sqrt(discriminant);
+        float d_min = r - p.R_e;
+        float d_max = rho;
+        float x = d_max == d_min ? 0.0f : (d - d_min) / (d_max - d_min);
+        u_mu = 0.5f - 0.5f * to_texel_center(glm::clamp(x, 0.0f, 1.0f), halfMu);
+    }
+    else
+    {
+        float d = -r_mu + safe_sqrt(discriminant + H * H);
+        float d_min = p.R_a - r;
+        float d_max = rho + H;
+        float x = (d - d_min) / (d_max - d_min);
+        u_mu = 0.5f + 0.5f * to_texel_center(glm::clamp(x, 0.0f, 1.0f), halfMu);
+    }
+
+    float u_mu_s = to_texel_center(mu_s_to_unit(mu_s), m_scattering.xSize);
+    float u_nu = (nu + 1.0f) * 0.5f;
+
+    return glm::vec4(u_mu_s, u_mu, u_r, u_nu);
+}
+
+void ScatteringTables::from_texel(int x, int y, int z, int w, float& r,
+                                  float& mu, float& mu_s, float& nu,
+                                  bool& rayGround) const
+{
+    const AtmosphereParams& p = m_params;
+    const float H = safe_sqrt(p.R_a * p.R_a - p.R_e * p.R_e);
+    const int halfMu = m_scattering.ySize / 2;
+
+    float rho = H * float(z) / float(m_scattering.zSize - 1);
+    r = safe_sqrt(rho * rho + p.R_e * p.R_e);
+
+    if (y < halfMu)
+    {
+        // Ray towards the ground, first half is stored reversed
+        float xMu = float(halfMu - 1 - y) / float(halfMu - 1);
+        float d_min = r - p.R_e;
+        float d_max = rho;
+        float d = d_min + xMu * (d_max - d_min);
+        mu = d == 0.0f ? -1.0f :
+             glm::clamp(-(rho * rho + d * d) / (2.0f * r * d), -1.0f, 1.0f);
+        rayGround = true;
+    }
+    else
+    {
+        float xMu = float(y - halfMu) / float(halfMu - 1);
+        float d_min = p.R_a - r;
+        float d_max = rho + H;
+        float d = d_min + xMu * (d_max - d_min);
+        mu = d == 0.0f ? 1.0f :
+             glm::clamp((H * H - rho * rho - d * d) / (2.0f * r * d), -1.0f, 1.0f);
+        rayGround = false;
+    }
+
+    mu_s = glm::clamp(unit_to_mu_s(float(x) / float(m_scattering.xSize - 1)),
+                      -1.0f, 1.0f);
+    nu = -1.0f + 2.0f * float(w) / float(m_scattering.wSize - 1);
+
+    // Only some view-sun angles are possible for given view and sun zenith
+    float s = safe_sqrt((1.0f - mu * mu) * (1.0f - mu_s * mu_s));
+    nu = glm::clamp(nu, mu * mu_s - s, mu * mu_s + s);
+}
+
+// ----------------------------------------------------------------------------
+// Lookups
+// ----------------------------------------------------------------------------
+glm::vec3 ScatteringTables::lookup(const LUT4D& table, float r, float mu,
+                                   float mu_s, float nu, bool rayGround) const
+{
+    glm::vec4 uvwz = to_uvwz(r, mu, mu_s, nu, rayGround);
+    return table.sample(uvwz.x, uvwz.y, uvwz.z, uvwz.w);
+}
+
+glm::vec3 ScatteringTables::lookup_irradiance(const LUT2D& table, float r,
+                                              float mu_s) const
+{
+    float x_r = (r - m_params.R_e) / (m_params.R_a - m_params.R_e);
+    return table.sample(to_texel_center(mu_s * 0.5f + 0.5f, table.width),
+                        to_texel_center(glm::clamp(x_r, 0.0f, 1.0f), table.height));
+}
+
+glm::vec3 ScatteringTables::transmittance_to(float r, float mu, float d,
+                                             bool rayGround) const
+{
+    float r_d = glm::clamp(std::sqrt(d * d + 2.0f * r * mu * d + r * r),
+                           m_params.R_e, m_params.R_a);
+    float mu_d = glm::clamp((r * mu + d) / r_d, -1.0f, 1.0f);
+
+    // Near the horizon the filtered table darkens by the zeros of the rays
+    //  hitting the ground, the segment is integrated instead
+    float mu_0 = rayGround ? -mu : mu;
+    float mu_1 = rayGround ? -mu_d : mu_d;
+    if (m_transmittance.blends_horizon(r, mu_0) || 
+        m_transmittance.blends_horizon(r_d, mu_1))
+    {
+        glm::vec3 o(0.0f, r, 0.0f);
+        glm::vec3 dir(safe_sqrt(1.0f - mu * mu), mu, 0.0f);
+        return extinction(m_params, optical_depth(m_params, o, dir, d, 
+                                                  SCATTERING_SAMPLES));
+    }
+
+    // Ratio of transmittances towards the top, reversed for the ground rays
+    glm::vec3 a, b;
+    if (rayGround)
+    {
+        a = m_transmittance.lookup(r_d, -mu_d);
+        b = m_transmittance.lookup(r, -mu);
+    }
+    else
+    {
+        a = m_transmittance.lookup(r, mu);
+        b = m_transmittance.lookup(r_d, mu_d);
+    }
+
+    return glm::vec3(b.x > 0.0f ? glm::min(a.x / b.x, 1.0f) : 0.0f,
+                     b.y > 0.0f ? glm::min(a.y / b.y, 1.0f) : 0.0f,
+                     b.z > 0.0f ? glm::min(a.z / b.z, 1.0f) : 0.0f);
+}
+
+glm::vec3 ScatteringTables::radiance_of_order(int order, float r, float mu,
+                                              float mu_s, float nu,
+                                              bool rayGround) const
+{
+    if (order == 1)
+    {
+        return lookup(m_deltaRayleigh, r, mu, mu_s, nu, rayGround) * phase_rayleigh(nu) +
+               lookup(m_mieScattering, r, mu, mu_s, nu, rayGround) * phase_mie(m_params.g, nu);
+    }
+
+    return lookup(m_deltaMultiple, r, mu, mu_s, nu, rayGround);
+}
+
+// ----------------------------------------------------------------------------
+// Precomputation
+// ----------------------------------------------------------------------------
+ScatteringTables::ScatteringTables()
+{
+    m_irradiance.resize(IRRADIANCE_LUT_WIDTH, IRRADIANCE_LUT_HEIGHT);
+    m_deltaIrradiance.resize(IRRADIANCE_LUT_WIDTH, IRRADIANCE_LUT_HEIGHT);
+
+    for (LUT4D* t : { &m_scattering, &m_mieScattering, &m_deltaRayleigh,
+                      &m_deltaMultiple, &m_deltaDensity })
+    {
+        t->resize(SCATTERING_MU_S_SIZE, SCATTERING_MU_SIZE,
+                  SCATTERING_R_SIZE, SCATTERING_NU_SIZE);
+    }
+}
+
+template<typename Fn>
+void ScatteringTables::for_each_texel(Fn&& fn)
+{
+    const LUT4D& t = m_scattering;
+
+    // Slices of altitude and view zenith are split across the cores
+    parallel_for(0, t.zSize * t.ySize, [&](int i) {
+        int z = i / t.ySize;
+        int y = i % t.ySize;
+        for (int w = 0; w < t.wSize; ++w)
+            for (int x = 0; x < t.xSize; ++x)
+                fn(x, y, z, w);
+    });
+}
+
+void ScatteringTables::bake(const AtmosphereParams& p, int orders)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    m_params = p;
+    m_orders = orders;
+    m_transmittance.bake(p);
+
+    compute_single_scattering();
+    m_scattering.data = m_deltaRayleigh.data;
+
+    // Direct irradiance lights the ground for the second order,
+    //  it is not part of the stored irradiance
+    for (int y = 0; y < m_deltaIrradiance.height; ++y)
+    {
+        float r = p.R_e + (p.R_a - p.R_e) * float(y) / float(m_deltaIrradiance.height - 1);
+        for (int x = 0; x < m_deltaIrradiance.width; ++x)
+        {
+            float mu_s = -1.0f + 2.0f * float(x) / float(m_deltaIrradiance.width - 1);
+            m_deltaIrradiance.at(x, y) = m_transmittance.lookup(r, mu_s) *
+                                         glm::max(mu_s, 0.0f);
+        }
+    }
+    std::fill(m_irradiance.data.begin(), m_irradiance.data.end(), glm::vec3(0.0f));
+
+    for (int order = 2; order <= orders; ++order)
+    {
+        compute_scattering_density(order);
+        compute_indirect_irradiance(order - 1);
+        compute_multiple_scattering();
+
+        // Multiple scattering is stored divided by the Rayleigh phase function,
+        //  which is applied back in the shader
+        for_each_texel([&](int x, int y, int z, int w) {
+            float r, mu, mu_s, nu;
+            bool rayGround;
+            from_texel(x, y, z, w, r, mu, mu_s, nu, rayGround);
+            m_scattering.at(x, y, z, w) += m_deltaMultiple.at(x, y, z, w) /
+                                           phase_rayleigh(nu);
+        });
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    m_bakeSeconds = elapsed.count();
+}
+
+void ScatteringTables::compute_single_scattering()
+{
+    const AtmosphereParams& p = m_params;
+
+    for_each_texel([&](int x, int y, int z, int w) {
+        float r, mu, mu_s, nu;
+        bool rayGround;
+        from_texel(x, y, z, w, r, mu, mu_s, nu, rayGround);
+
+        const int n = SCATTERING_SAMPLES;
+        float dx = distance_to_boundary(p, r, mu, rayGround) / float(n);
+
+        glm::vec3 sum_R(0.0f), sum_M(0.0f);
+        for (int i = 0; i <= n; ++i)
+        {
+            float d = float(i) * dx;
+            float r_d = glm::clamp(std::sqrt(d * d + 2.0f * r * mu * d + r * r),
+                                   p.R_e, p.R_a);
+            float mu_s_d = glm::clamp((r * mu_s + d * nu) / r_d, -1.0f, 1.0f);
+
+            glm::vec3 att = transmittance_to(r, mu, d, rayGround) *
+                            m_transmittance.lookup(r_d, mu_s_d);
+            float weight = trapezoid_weight(i, n);
+            sum_R += att * density_rayleigh(p, r_d) * weight;
+            sum_M += att * density_mie(p, r_d) * weight;
+        }
+
+        m_deltaRayleigh.at(x, y, z, w) = sum_R * dx * p.beta_R;
+        m_mieScattering.at(x, y, z, w) = sum_M * dx * p.beta_M;
+    });
+}
+
+void ScatteringTables::compute_scattering_density(int order)
+{
+    const AtmosphereParams& p = m_params;
+
+    for_each_texel([&](int x, int y, int z, int w) {
+        float r, mu, mu_s, nu;
+        bool rayGround;
+        from_texel(x, y, z, w, r, mu, mu_s, nu, rayGround);
+
+        // Directions of the view and the sun in a local frame, zenith is +y
+        glm::vec3 omega(safe_sqrt(1.0f - mu * mu), mu, 0.0f);
+        float sun_x = omega.x == 0.0f ? 0.0f : (nu - mu * mu_s) / omega.x;
+        glm::vec3 omega_s(sun_x, mu_s, safe_sqrt(1.0f - sun_x * sun_x - mu_s * mu_s));
+
+        const float dTheta = float(M_PI) / SPHERE_SAMPLES;
+        const float dPhi = float(M_PI) / SPHERE_SAMPLES;
+        glm::vec3 beta_R = p.beta_R * density_rayleigh(p, r);
+        float beta_M = p.beta_M * density_mie(p, r);
+
+        glm::vec3 density(0.0f);
+        for (int l = 0; l < SPHERE_SAMPLES; ++l)
+        {
+            float theta = (float(l) + 0.5f) * dTheta;
+            float cosTheta = std::cos(theta);
+            float sinTheta = std::sin(theta);
+            bool incidentGround = ray_intersects_ground(p, r, cosTheta);
+
+            // Transmittance to the ground is the same for all azimuths
+            float groundDist = 0.0f;
+            glm::vec3 groundT(0.0f);
+            if (incidentGround)
+            {
+                groundDist = distance_to_bottom(p, r, cosTheta);
+                groundT = transmittance_to(r, cosTheta, groundDist, true);
+            }
+
+            for (int m = 0; m < 2 * SPHERE_SAMPLES; ++m)
+            {
+                float phi = (float(m) + 0.5f) * dPhi;
+                glm::vec3 omega_i(std::cos(phi) * sinTheta, cosTheta,
+                                  std::sin(phi) * sinTheta);
+                float dOmega = dTheta * dPhi * sinTheta;
+
+                // Radiance of the previous order coming from omega_i
+                float nu1 = glm::dot(omega_s, omega_i);
+                glm::vec3 incident = radiance_of_order(order - 1, r, cosTheta,
+                                                       mu_s, nu1, incidentGround);
+
+                // Light reflected from the ground, lit by the previous order
+                if (incidentGround)
+                {
+                    glm::vec3 normal = glm::normalize(glm::vec3(0.0f, r, 0.0f) +
+                                                      omega_i * groundDist);
+                    glm::vec3 E = lookup_irradiance(m_deltaIrradiance, p.R_e,
+                                                    glm::dot(normal, omega_s));
+                    incident += groundT * (GROUND_ALBEDO / float(M_PI)) * E;
+                }
+
+                float nu2 = glm::dot(omega, omega_i);
+                density += incident * dOmega *
+                           (beta_R * phase_rayleigh(nu2) + beta_M * phase_mie(p.g, nu2));
+            }
+        }
+
+        m_deltaDensity.at(x, y, z, w) = density;
+    });
+}
+
+void ScatteringTables::compute_indirect_irradiance(int order)
+{
+    const AtmosphereParams& p = m_params;
+    const int samples = 2 * SPHERE_SAMPLES;
+    const float dTheta = 0.5f * float(M_PI) / samples;
+    const float dPhi = 0.5f * float(M_PI) / samples;
+
+    parallel_for(0, m_deltaIrradiance.height, [&](int y) {
+        float r = p.R_e + (p.R_a - p.R_e) * float(y) / float(m_deltaIrradiance.height - 1);
+
+        for (int x = 0; x < m_deltaIrradiance.width; ++x)
+        {
+            float mu_s = -1.0f + 2.0f * float(x) / float(m_deltaIrradiance.width - 1);
+            glm::vec3 omega_s(safe_sqrt(1.0f - mu_s * mu_s), mu_s, 0.0f);
+
+            // Integrate over the upper hemisphere
+            glm::vec3 E(0.0f);
+            for (int j = 0; j < samples; ++j)
+            {
+                float theta = (float(j) + 0.5f) * dTheta;
+                float cosTheta = std::cos(theta);
+                float sinTheta = std::sin(theta);
+                bool rayGround = ray_intersects_ground(p, r, cosTheta);
+
+                for (int i = 0; i < 4 * samples; ++i)
+                {
+                    float phi = (float(i) + 0.5f) * dPhi;
+                    glm::vec3 omega(std::cos(phi) * sinTheta, cosTheta,
+                                    std::sin(phi) * sinTheta);
+                    float dOmega = dTheta * dPhi * sinTheta;
+                    float nu = glm::dot(omega, omega_s);
+
+                    E += radiance_of_order(order, r, cosTheta, mu_s, nu, rayGround) *
+                         cosTheta * dOmega;
+                }
+            }
+
+            m_deltaIrradiance.at(x, y) = E;
+            m_irradiance.at(x, y) += E;
+        }
+    });
+}
+
+void ScatteringTables::compute_multiple_scattering()
+{
+    const AtmosphereParams& p = m_params;
+
+    for_each_texel([&](int x, int y, int z, int w) {
+        float r, mu, mu_s, nu;
+        bool rayGround;
+        from_texel(x, y, z, w, r, mu, mu_s, nu, rayGround);
+
+        const int n = SCATTERING_SAMPLES;
+        float dx = distance_to_boundary(p, r, mu, rayGround) / float(n);
+
+        glm::vec3 sum(0.0f);
+        for (int i = 0; i <= n; ++i)
+        {
+            float d = float(i) * dx;
+            float r_d = glm::clamp(std::sqrt(d * d + 2.0f * r * mu * d + r * r),
+                                   p.R_e, p.R_a);
+            float mu_d = glm::clamp((r * mu + d) / r_d, -1.0f, 1.0f);
+            float mu_s_d = glm::clamp((r * mu_s + d * nu) / r_d, -1.0f, 1.0f);
+
+            sum += lookup(m_deltaDensity, r_d, mu_d, mu_s_d, nu, rayGround) *
+                   transmittance_to(r, mu, d, rayGround) * trapezoid_weight(i, n);
+        }
+
+        m_deltaMultiple.at(x, y, z, w) = sum * dx;
+    });
+}
+
+// ----------------------------------------------------------------------------
+// Rendering
+// ----------------------------------------------------------------------------
+glm::vec3 ScatteringTables::sky_radiance(const glm::vec3& camera,
+                                         const glm::vec3& view,
+                                         const glm::vec3& sun) const
+{
+    const AtmosphereParams& p = m_params;
+    glm::vec3 x = camera;
+    float r = glm::length(x);
+    float r_mu = glm::dot(x, view);
+
+    // Move the camera in space to the top of the atmosphere
+    float distToTop = -r_mu - safe_sqrt(r_mu * r_mu - r * r + p.R_a * p.R_a);
+    if (distToTop > 0.0f)
+    {
+        x += view * distToTop;
+        r = p.R_a;
+        r_mu += distToTop;
+    }
+    else if (r > p.R_a)
+    {
+        // View ray does not hit the atmosphere
+        return glm::vec3(0.0f);
+    }
+
+    float mu = r_mu / r;
+    float mu_s = glm::dot(x, sun) / r;
+    float nu = glm::dot(view, sun);
+    bool rayGround = ray_intersects_ground(p, r, mu);
+
+    glm::vec3 scattering = lookup(m_scattering, r, mu, mu_s, nu, rayGround);
+    glm::vec3 mie = lookup(m_mieScattering, r, mu, mu_s, nu, rayGround);
+
+    return p.I_sun * (scattering * phase_rayleigh(nu) + mie * phase_mie(p.g, nu));
+}
+
@@ -0,0 +1,126 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file scattering_tables.hpp
+ * @brief Precomputed single and multiple scattering,
+ *        based on Bruneton and Neyret
+ *********************************************************/
+
+#pragma once
+
+#include "atmosphere_model.hpp"
+#include "transmittance_lut.hpp"
+#include "lut2d.hpp"
+#include "lut4d.hpp"
+
+
+// Resolution of the 4D scattering table
+#define SCATTERING_R_SIZE       16  ///< Altitude
+#define SCATTERING_MU_SIZE      64  ///< View zenith, half for ground rays
+#define SCATTERING_MU_S_SIZE    16  ///< Sun zenith
+#define SCATTERING_NU_SIZE      8   ///< View-sun angle
+
+// Resolution of the ground irradiance table
+#define IRRADIANCE_LUT_WIDTH    64  ///< Sun zenith
+#define IRRADIANCE_LUT_HEIGHT   16  ///< Altitude
+
+#define SCATTERING_SAMPLES      32  ///< Samples along each view ray
+#define SPHERE_SAMPLES          8   ///< Zenith samples when integrating
+                                    ///<  over directions, azimuth is double
+
+#define DEFAULT_SCATTERING_ORDERS 4
+#define MAX_SCATTERING_ORDERS     8
+
+
+/**
+ * @brief Bakes tables of precomputed atmospheric scattering on the CPU:
+ *  - transmittance towards the top of the atmosphere (r, mu),
+ *  - indirect irradiance at altitude (r, mu_s), without the direct sun light,
+ *  - scattering (r, mu, mu_s, nu), single Rayleigh plus all multiple
+ *    scattering orders, divided by the Rayleigh phase function,
+ *  - single Mie scattering (r, mu, mu_s, nu), without the phase function.
+ *
+ *  Radiance is for the sun of unit intensity, the caller multiplies by I_sun.
+ *  The scattering tables are laid out as 3D textures of dimensions
+ *  (NU * MU_S, MU, R), the parametrization is mirrored in the shader
+ *  draw_atmosphere_precomputed.frag.
+ */
+class ScatteringTables
+{
+public:
+    ScatteringTables();
+
+    /**
+     * @brief (Re)computes all the tables
+     * @param p Properties of the atmosphere
+     * @param orders Number of scattering orders, 1 for single scattering only
+     */
+    void bake(const AtmosphereParams& p, int orders = DEFAULT_SCATTERING_ORDERS);
+
+    /**
+     * @brief Radiance of the sky computed from the tables, the same way as
+     *  in the shader, compared with the CPU reference by run_validation to
+     *  tell the error of the tables from the error of the shader
+     * @param camera Position of the camera
+     * @param view Normalized direction of the view ray
+     * @param sun Normalized direction towards the sun
+     * @return Radiance for the sun intensity of the baked params
+     */
+    glm::vec3 sky_radiance(const glm::vec3& camera, const glm::vec3& view,
+                           const glm::vec3& sun) const;
+
+    const TransmittanceLUT& transmittance() const { return m_transmittance; }
+    const LUT2D& irradiance() const { return m_irradiance; }
+    const LUT4D& scattering() const { return m_scattering; }
+    const LUT4D& mieScattering() const { return m_mieScattering; }
+
+    /** @return Number of scattering orders of the last bake */
+    int orders() const { return m_orders; }
+    /** @return Duration of the last bake in seconds, for the log */
+    double bake_seconds() const { return m_bakeSeconds; }
+
+private:
+    // Texture coordinates of the 4D table for the parameters
+    glm::vec4 to_uvwz(float r, float mu, float mu_s, float nu,
+                      bool rayGround) const;
+
+    // Parameters of the texel of the 4D table
+    void from_texel(int x, int y, int z, int w, float& r, float& mu,
+                    float& mu_s, float& nu, bool& rayGround) const;
+
+    glm::vec3 lookup(const LUT4D& table, float r, float mu, float mu_s,
+                     float nu, bool rayGround) const;
+
+    glm::vec3 lookup_irradiance(const LUT2D& table, float r, float mu_s) const;
+
+    // Transmittance between the point (r, mu) and a point at distance d
+    glm::vec3 transmittance_to(float r, float mu, float d, bool rayGround) const;
+
+    // Radiance of scattering order n towards the point (r, mu, mu_s, nu)
+    glm::vec3 radiance_of_order(int order, float r, float mu, float mu_s,
+                                float nu, bool rayGround) const;
+
+    void compute_single_scattering();
+    void compute_scattering_density(int order);
+    void compute_indirect_irradiance(int order);
+    void compute_multiple_scattering();
+
+    // Calls fn(x, y, z, w) for every texel of the 4D table in parallel
+    template<typename Fn> void for_each_texel(Fn&& fn);
+
+private:
+    AtmosphereParams m_params;
+    int m_orders = 0;
+    double m_bakeSeconds = 0.0;
+
+    TransmittanceLUT m_transmittance;
+    LUT2D m_irradiance;
+    LUT4D m_scattering;
+    LUT4D m_mieScattering;
+
+    // Intermediate tables of a single scattering order
+    LUT2D m_deltaIrradiance;
+    LUT4D m_deltaRayleigh;
+    LUT4D m_deltaMultiple;
+    LUT4D m_deltaDensity;
+};
+
@@ -0,0 +1,260 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file simd.hpp
+ * @brief Packets of floats processed in SIMD lanes
+ *********************************************************/
+
+#pragma once
+
+#include <cmath>
+
+// Widest instruction set enabled for the translation unit, AVX2 has to be
+//  enabled by the compiler flags (see USE_AVX2 in CMakeLists.txt)
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || \
+      (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SIMD_WIDTH 4
+#else
+    #define SIMD_WIDTH 1
+#endif
+
+
+/**
+ * @brief SIMD_WIDTH floats, one per lane. All the operations are lane-wise.
+ *  Branches are replaced by masks of lanes, see select().
+ */
+struct vfloat
+{
+#if SIMD_WIDTH == 8
+    __m256 v;
+    vfloat() = default;
+    vfloat(float f) : v(_mm256_set1_ps(f)) {}
+    explicit vfloat(__m256 n) : v(n) {}
+
+    static vfloat load(const float* p) { return vfloat(_mm256_loadu_ps(p)); }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+#elif SIMD_WIDTH == 4
+    __m128 v;
+    vfloat() = default;
+    vfloat(float f) : v(_mm_set1_ps(f)) {}
+    explicit vfloat(__m128 n) : v(n) {}
+
+    static vfloat load(const float* p) { return vfloat(_mm_loadu_ps(p)); }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+#else
+    float v;
+    vfloat() = default;
+    vfloat(float f) : v(f) {}
+
+    static vfloat load(const float* p) { return vfloat(*p); }
+    void store(float* p) const { *p = v; }
+#endif
+};
+
+/** @brief Result of a lane-wise comparison, all bits set in true lanes */
+struct vmask
+{
+#if SIMD_WIDTH == 8
+    __m256 m;
+#elif SIMD_WIDTH == 4
+    __m128 m;
+#else
+    bool m;
+#endif
+};
+
+#if SIMD_WIDTH == 8
+
+inline vfloat operator+(vfloat a, vfloat b) { return vfloat(_mm256_add_ps(a.v, b.v)); }
+inline vfloat operator-(vfloat a, vfloat b) { return vfloat(_mm256_sub_ps(a.v, b.v)); }
+inline vfloat operator*(vfloat a, vfloat b) { return vfloat(_mm256_mul_ps(a.v, b.v)); }
+inline vfloat operator/(vfloat a, vfloat b) { return vfloat(_mm256_div_ps(a.v, b.v)); }
+inline vfloat operator-(vfloat a) { return vfloat(_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))); }
+
+inline vfloat min(vfloat a, vfloat b) { return vfloat(_mm256_min_ps(a.v, b.v)); }
+inline vfloat max(vfloat a, vfloat b) { return vfloat(_mm256_max_ps(a.v, b.v)); }
+inline vfloat sqrt(vfloat a) { return vfloat(_mm256_sqrt_ps(a.v)); }
+
+inline vmask operator<(vfloat a, vfloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline vmask operator>(vfloat a, vfloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline vmask operator&(vmask a, vmask b) { return { _mm256_and_ps(a.m, b.m) }; }
+inline vmask operator|(vmask a, vmask b) { return { _mm256_or_ps(a.m, b.m) }; }
+
+/** @return a in the lanes where mask is set, b elsewhere */
+inline vfloat select(vmask mask, vfloat a, vfloat b)
+{
+    return vfloat(_mm256_blendv_ps(b.v, a.v, mask.m));
+}
+
+inline bool any(vmask mask) { return _mm256_movemask_ps(mask.m) != 0; }
+
+/** @brief Rounds to the nearest integer */
+inline vfloat round(vfloat a)
+{
+    return vfloat(_mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+/** @brief 2^n, n has to be an integer in the range of normal floats */
+inline vfloat pow2(vfloat n)
+{
+    __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n.v), _mm256_set1_epi32(127));
+    return vfloat(_mm256_castsi256_ps(_mm256_slli_epi32(e, 23)));
+}
+
+#elif SIMD_WIDTH == 4
+
+inline vfloat operator+(vfloat a, vfloat b) { return vfloat(_mm_add_ps(a.v, b.v)); }
+inline vfloat operator-(vfloat a, vfloat b) { return vfloat(_mm_sub_ps(a.v, b.v)); }
+inline vfloat operator*(vfloat a, vfloat b) { return vfloat(_mm_mul_ps(a.v, b.v)); }
+inline vfloat operator/(vfloat a, vfloat b) { return vfloat(_mm_div_ps(a.v, b.v)); }
+inline vfloat operator-(vfloat a) { return vfloat(_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))); }
+
+inline vfloat min(vfloat a, vfloat b) { return vfloat(_mm_min_ps(a.v, b.v)); }
+inline vfloat max(vfloat a, vfloat b) { return vfloat(_mm_max_ps(a.v, b.v)); }
+inline vfloat sqrt(vfloat a) { return vfloat(_mm_sqrt_ps(a.v)); }
+
+inline vmask operator<(vfloat a, vfloat b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline vmask operator>(vfloat a, vfloat b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline vmask operator&(vmask a, vmask b) { return { _mm_and_ps(a.m, b.m) }; }
+inline vmask operator|(vmask a, vmask b) { return { _mm_or_ps(a.m, b.m) }; }
+
+/** @return a in the lanes where mask is set, b elsewhere */
+inline vfloat select(vmask mask, vfloat a, vfloat b)
+{
+    // No blend instruction in SSE2
+    return vfloat(_mm_or_ps(_mm_and_ps(mask.m, a.v), _mm_andnot_ps(mask.m, b.v)));
+}
+
+inline bool any(vmask mask) { return _mm_movemask_ps(mask.m) != 0; }
+
+/** @brief Rounds to the nearest integer */
+inline vfloat round(vfloat a)
+{
+    return vfloat(_mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)));
+}
+
+/** @brief 2^n, n has to be an integer in the range of normal floats */
+inline vfloat pow2(vfloat n)
+{
+    __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127));
+    return vfloat(_mm_castsi128_ps(_mm_slli_epi32(e, 23)));
+}
+
+#else
+
+inline vfloat operator+(vfloat a, vfloat b) { return a.v + b.v; }
+inline vfloat operator-(vfloat a, vfloat b) { return a.v - b.v; }
+inline vfloat operator*(vfloat a, vfloat b) { return a.v * b.v; }
+inline vfloat operator/(vfloat a, vfloat b) { return a.v / b.v; }
+inline vfloat operator-(vfloat a) { return -a.v; }
+
+inline vfloat min(vfloat a, vfloat b) { return a.v < b.v ? a : b; }
+inline vfloat max(vfloat a, vfloat b) { return a.v > b.v ? a : b; }
+inline vfloat sqrt(vfloat a) { return std::sqrt(a.v); }
+
+inline vmask operator<(vfloat a, vfloat b) { return { a.v < b.v }; }
+inline vmask operator>(vfloat a, vfloat b) { return { a.v > b.v }; }
+inline vmask operator&(vmask a, vmask b) { return { a.m && b.m }; }
+inline vmask operator|(vmask a, vmask b) { return { a.m || b.m }; }
+
+/** @return a in the lanes where mask is set, b elsewhere */
+inline vfloat select(vmask mask, vfloat a, vfloat b) { return mask.m ? a : b; }
+
+inline bool any(vmask mask) { return mask.m; }
+
+/** @brief Rounds to the nearest integer */
+inline vfloat round(vfloat a) { return std::nearbyint(a.v); }
+
+/** @brief 2^n, n has to be an integer in the range of normal floats */
+inline vfloat pow2(vfloat n) { return std::ldexp(1.0f, int(n.v)); }
+
+#endif
+
+inline vfloat& operator+=(vfloat& a, vfloat b) { return a = a + b; }
+inline vfloat& operator*=(vfloat& a, vfloat b) { return a = a * b; }
+
+/**
+ * @brief Exponential function, Cephes polynomial after the reduction
+ *  exp(x) = 2^n * exp(r), |r| <= ln(2) / 2, relative error about 2e-7.
+ *  Same in all the lanes and instruction sets.
+ */
+inline vfloat exp(vfloat x)
+{
+    x = min(max(x, -87.3f), 88.3f);
+
+    vfloat n = round(x * 1.44269504f);
+    // ln(2) split in two parts, the first one is exact in float
+    vfloat r = x - n * 0.693359375f + n * 2.12194440e-4f;
+
+    vfloat p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    p = p * r * r + r + 1.0f;
+
+    return p * pow2(n);
+}
+
+/** @brief Three packets forming vectors, structure of arrays */
+struct vvec3
+{
+    vfloat x, y, z;
+
+    vvec3() = default;
+    vvec3(vfloat x, vfloat y, vfloat z) : x(x), y(y), z(z) {}
+};
+
+inline vvec3 operator+(const vvec3& a, const vvec3& b)
+{
+    return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+inline vvec3 operator*(const vvec3& a, vfloat s)
+{
+    return { a.x * s, a.y * s, a.z * s };
+}
+inline vfloat dot(const vvec3& a, const vvec3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+inline vfloat length(const vvec3& a) { return sqrt(dot(a, a)); }
+inline vfloat abs(vfloat a) { return max(a, -a); }
+
+/**
+ * @brief Cube root of x in [0.008, 1.1], the range of the CIE Lab transfer
+ *  function, five Newton iterations from a linear guess. Relative error
+ *  at the float precision.
+ */
+inline vfloat cbrt_unit(vfloat x)
+{
+    vfloat y = x * 0.65f + 0.35f;
+    for (int i = 0; i < 5; ++i)
+        y = (y + y + x / (y * y)) * (1.0f / 3.0f);
+    return y;
+}
+
+/** @return Sum of all the lanes */
+inline float reduce_add(vfloat a)
+{
+    alignas(32) float lanes[SIMD_WIDTH];
+    a.store(lanes);
+    float sum = 0.0f;
+    for (int l = 0; l < SIMD_WIDTH; ++l)
+        sum += lanes[l];
+    return sum;
+}
+
+/** @return Maximum of all the lanes */
+inline float reduce_max(vfloat a)
+{
+    alignas(32) float lanes[SIMD_WIDTH];
+    a.store(lanes);
+    float m = lanes[0];
+    for (int l = 1; l < SIMD_WIDTH; ++l)
+        m = lanes[l] > m ? lanes[l] : m;
+    return m;
+}
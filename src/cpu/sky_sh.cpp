@@ -0,0 +1,141 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file sky_sh.cpp
+ * @brief Spherical harmonics of the sky irradiance around
+ *        the viewer
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "sky_sh.hpp"
+#include "parallel.hpp"
+#include "reference_renderer.hpp"
+
+
+static_assert(SKY_SH_DIRECTIONS % SKY_SH_TASK_DIRECTIONS == 0,
+              "Tasks have to cover the directions evenly");
+
+/** @return Real SH basis of bands 0 to 2, in the order of SkySH */
+static std::array<float, SKY_SH_COEFFICIENTS> sh_basis(const glm::vec3& d)
+{
+    return {
+        0.282095f,
+        0.488603f * d.y, 0.488603f * d.z, 0.488603f * d.x,
+        1.092548f * d.x * d.y, 1.092548f * d.y * d.z,
+        0.315392f * (3.0f * d.z * d.z - 1.0f),
+        1.092548f * d.x * d.z, 0.546274f * (d.x * d.x - d.y * d.y)
+    };
+}
+
+SkySH::SkySH()
+  : m_params(), m_viewPos(0.0f), m_sunDir(0.0f)
+{
+    m_dirs.resize(SKY_SH_DIRECTIONS);
+    m_basis.resize(SKY_SH_DIRECTIONS);
+    m_radiance.resize(SKY_SH_DIRECTIONS, glm::vec3(0.0f));
+    m_coefficients.fill(glm::vec3(0.0f));
+
+    for (int i = 0; i < SKY_SH_DIRECTIONS; ++i)
+    {
+        m_dirs[i] = fibonacci_direction(i, SKY_SH_DIRECTIONS);
+        m_basis[i] = sh_basis(m_dirs[i]);
+    }
+}
+
+void SkySH::project(const AtmosphereParams& p, const glm::vec3& viewPos,
+                    const glm::vec3& sunDir, 
+                    const MultipleScatteringLUT& multipleScattering)
+{
+    m_params = p;
+    m_viewPos = viewPos;
+    m_sunDir = sunDir;
+
+    const int tasks = SKY_SH_DIRECTIONS / SKY_SH_TASK_DIRECTIONS;
+    parallel_for(0, tasks, [this, &multipleScattering](int task) {
+        trace(task * SKY_SH_TASK_DIRECTIONS, SKY_SH_TASK_DIRECTIONS,
+              multipleScattering);
+    });
+
+    update_coefficients();
+}
+
+void SkySH::trace(int first, int count, 
+                  const MultipleScatteringLUT& multipleScattering)
+{
+    ReferenceView view;
+    view.viewPos = m_viewPos;
+    view.sunDir = m_sunDir;
+    view.viewSamples = SKY_SH_VIEW_SAMPLES;
+    view.lightSamples = SKY_SH_LIGHT_SAMPLES;
+
+    // Per unit intensity, scaled when lit
+    AtmosphereParams p = m_params;
+    p.I_sun = 1.0f;
+    reference_radiance(p, view, &m_dirs[first], count, &m_radiance[first]);
+
+    for (int i = first; i < first + count; ++i)
+        m_radiance[i] += multiple_scattering(m_dirs[i], multipleScattering);
+}
+
+glm::vec3 SkySH::multiple_scattering(const glm::vec3& d,
+                                     const MultipleScatteringLUT& lut) const
+{
+    const AtmosphereParams& p = m_params;
+
+    // Segment inside of the atmosphere, ending at the ground
+    glm::vec2 t = ray_sphere_intersection(m_viewPos, d, p.R_a);
+    if (t.y <= 0.0f)
+        return glm::vec3(0.0f);
+    t.x = glm::max(t.x, 0.0f);
+    glm::vec2 tGround = ray_sphere_intersection(m_viewPos, d, p.R_e);
+    if (tGround.x > 0.0f && tGround.x < t.y)
+        t.y = tGround.x;
+
+    // Midpoint samples attenuated up to the end of their segment, the same
+    //  way as the shader accumulates sum_MS
+    const int samples = SKY_SH_VIEW_SAMPLES;
+    float segmentLen = (t.y - t.x) / float(samples);
+    float optDepth_R = 0.0f, optDepth_M = 0.0f;
+    glm::vec3 L(0.0f);
+
+    for (int i = 0; i < samples; ++i)
+    {
+        glm::vec3 x = m_viewPos + d * (t.x + (i + 0.5f) * segmentLen);
+        float r_x = glm::length(x);
+        float height = r_x - p.R_e;
+
+        float h_R = std::exp(-height / p.H_R) * segmentLen;
+        float h_M = std::exp(-height / p.H_M) * segmentLen;
+        optDepth_R += h_R;
+        optDepth_M += h_M;
+
+        glm::vec3 viewAtt = glm::exp(-(p.beta_R * optDepth_R + 
+                                       glm::vec3(p.beta_M * MIE_EXTINCTION_FACTOR *
+                                                 optDepth_M)));
+        glm::vec3 psi_ms = lut.lookup(r_x, glm::dot(x, m_sunDir) / r_x);
+
+        L += viewAtt * psi_ms * (p.beta_R * h_R + glm::vec3(p.beta_M * h_M));
+    }
+
+    return L;
+}
+
+void SkySH::update_coefficients()
+{
+    // Convolution with the clamped cosine per band, after Ramamoorthi and
+    //  Hanrahan, each direction covers the solid angle 4 pi / N
+    static const float bandFactor[SKY_SH_COEFFICIENTS] = {
+        float(M_PI),
+        2.0f * float(M_PI) / 3.0f, 2.0f * float(M_PI) / 3.0f, 2.0f * float(M_PI) / 3.0f,
+        float(M_PI) / 4.0f, float(M_PI) / 4.0f, float(M_PI) / 4.0f,
+        float(M_PI) / 4.0f, float(M_PI) / 4.0f
+    };
+
+    m_coefficients.fill(glm::vec3(0.0f));
+    for (int i = 0; i < SKY_SH_DIRECTIONS; ++i)
+        for (int k = 0; k < SKY_SH_COEFFICIENTS; ++k)
+            m_coefficients[k] += m_radiance[i] * m_basis[i][k];
+
+    for (int k = 0; k < SKY_SH_COEFFICIENTS; ++k)
+        m_coefficients[k] *= bandFactor[k] * 4.0f * float(M_PI) / 
+                             float(SKY_SH_DIRECTIONS);
+}
@@ -0,0 +1,89 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file sky_sh.hpp
+ * @brief Spherical harmonics of the sky irradiance around
+ *        the viewer
+ *********************************************************/
+
+#pragma once
+
+#include "atmosphere_model.hpp"
+#include "multiple_scattering_lut.hpp"
+
+#include <array>
+#include <vector>
+
+
+#define SKY_SH_COEFFICIENTS     9   ///< Bands 0 to 2
+#define SKY_SH_DIRECTIONS       512 ///< Fibonacci directions over the sphere
+#define SKY_SH_TASK_DIRECTIONS  64  ///< Directions traced per worker task
+#define SKY_SH_VIEW_SAMPLES     16  ///< Samples along each view ray
+#define SKY_SH_LIGHT_SAMPLES    8   ///< Samples along each light ray
+
+
+/**
+ * @brief Irradiance of the sky around the viewer in 9 spherical harmonics
+ *  coefficients, for the ambient light of surfaces of any orientation near
+ *  the viewer. Radiance is traced by reference_radiance over a Fibonacci
+ *  set of directions, plus multiple scattering of MultipleScatteringLUT
+ *  marched the same way as in the shader, as in GroundIrradianceLUT. It is
+ *  projected to the real SH basis and convolved with the clamped cosine,
+ *  without the intensity of the sun. Meant to be projected on the worker
+ *  threads, see AsyncTable, again whenever the sun or the viewer move.
+ *
+ *  Irradiance of a surface with the normal n (x, y, z):
+ *      E(n) = c0 * 0.282095
+ *           + c1 * 0.488603 y + c2 * 0.488603 z + c3 * 0.488603 x
+ *           + c4 * 1.092548 xy + c5 * 1.092548 yz + c6 * 0.315392 (3z^2 - 1)
+ *           + c7 * 1.092548 xz + c8 * 0.546274 (x^2 - y^2)
+ */
+class SkySH
+{
+public:
+    SkySH();
+
+    /**
+     * @brief Traces all the directions on the global ThreadPool and projects
+     *  them, blocks until done. Safe to call from a pool task.
+     * @param p Properties of the atmosphere
+     * @param viewPos Position of the viewer
+     * @param sunDir Direction towards the sun
+     * @param multipleScattering Table baked for the same properties
+     */
+    void project(const AtmosphereParams& p, const glm::vec3& viewPos,
+                 const glm::vec3& sunDir, 
+                 const MultipleScatteringLUT& multipleScattering);
+
+    /** @return Coefficients of the irradiance, see the class description */
+    const std::array<glm::vec3, SKY_SH_COEFFICIENTS>& coefficients() const
+    {
+        return m_coefficients;
+    }
+
+    /** @return Position of the viewer of the last projection */
+    const glm::vec3& viewPos() const { return m_viewPos; }
+    /** @return Direction towards the sun of the last projection */
+    const glm::vec3& sunDir() const { return m_sunDir; }
+
+private:
+    /** @brief Traces count directions from first, within the set */
+    void trace(int first, int count, 
+               const MultipleScatteringLUT& multipleScattering);
+
+    /** @return Multiple scattering towards the viewer along the direction */
+    glm::vec3 multiple_scattering(const glm::vec3& d,
+                                  const MultipleScatteringLUT& lut) const;
+
+    /** @brief Projects the radiance of all the directions */
+    void update_coefficients();
+
+private:
+    std::vector<glm::vec3> m_dirs;
+    std::vector<std::array<float, SKY_SH_COEFFICIENTS>> m_basis;  ///< Per direction
+    std::vector<glm::vec3> m_radiance;                            ///< Per direction
+    std::array<glm::vec3, SKY_SH_COEFFICIENTS> m_coefficients;
+
+    AtmosphereParams m_params;
+    glm::vec3 m_viewPos;
+    glm::vec3 m_sunDir;
+};
@@ -0,0 +1,91 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file spectrum.cpp
+ * @brief Wavelength bins of the spectral mode and their
+ *        conversion to RGB
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "spectrum.hpp"
+
+
+float spectral_wavelength(int bin)
+{
+    float width = (SPECTRAL_MAX_WAVELENGTH - SPECTRAL_MIN_WAVELENGTH) / SPECTRAL_BINS;
+    return SPECTRAL_MIN_WAVELENGTH + (float(bin) + 0.5f) * width;
+}
+
+void rayleigh_spectrum(const glm::vec3& beta_R, float beta[SPECTRAL_BINS])
+{
+    const glm::vec3 lambda = RGB_WAVELENGTHS;
+
+    for (int bin = 0; bin < SPECTRAL_BINS; ++bin)
+    {
+        float l = spectral_wavelength(bin);
+
+        // Segment green-red above the green wavelength, blue-green below
+        int i0 = l >= lambda.g ? 1 : 2;
+        int i1 = l >= lambda.g ? 0 : 1;
+
+        float exponent = std::log(beta_R[i1] / beta_R[i0]) / 
+                         std::log(lambda[i1] / lambda[i0]);
+        beta[bin] = beta_R[i0] * std::pow(l / lambda[i0], exponent);
+    }
+}
+
+/**
+ * @brief Piecewise Gaussian lobe of the analytic fit of the CIE 1931 
+ *  matching functions by Wyman, Sloan and Shirley
+ */
+static float cie_lobe(float l, float mu, float sigma1, float sigma2)
+{
+    float t = (l - mu) / (l < mu ? sigma1 : sigma2);
+    return std::exp(-0.5f * t * t);
+}
+
+/** @return CIE 1931 XYZ matching functions at the wavelength [nm] */
+static glm::vec3 cie_xyz(float l)
+{
+    return glm::vec3(
+        1.056f * cie_lobe(l, 599.8f, 37.9f, 31.0f) + 
+        0.362f * cie_lobe(l, 442.0f, 16.0f, 26.7f) -
+        0.065f * cie_lobe(l, 501.1f, 20.4f, 26.2f),
+        0.821f * cie_lobe(l, 568.8f, 46.9f, 40.5f) +
+        0.286f * cie_lobe(l, 530.9f, 16.3f, 31.1f),
+        1.217f * cie_lobe(l, 437.0f, 11.8f, 36.0f) +
+        0.681f * cie_lobe(l, 459.0f, 26.0f, 13.8f));
+}
+
+const std::array<glm::vec3, SPECTRAL_BINS>& spectral_to_rgb()
+{
+    static const std::array<glm::vec3, SPECTRAL_BINS> matrix = []() {
+        // XYZ to linear sRGB, columns
+        const glm::mat3 xyzToRgb(3.2406f, -0.9689f, 0.0557f,
+                                 -1.5372f, 1.8758f, -0.2040f,
+                                 -0.4986f, 0.0415f, 1.0570f);
+        const float width = (SPECTRAL_MAX_WAVELENGTH - SPECTRAL_MIN_WAVELENGTH) / 
+                            SPECTRAL_BINS;
+        const int steps = 32;
+
+        std::array<glm::vec3, SPECTRAL_BINS> m;
+        glm::vec3 white(0.0f);
+        for (int bin = 0; bin < SPECTRAL_BINS; ++bin)
+        {
+            glm::vec3 xyz(0.0f);
+            for (int s = 0; s < steps; ++s)
+            {
+                float l = SPECTRAL_MIN_WAVELENGTH + 
+                          (float(bin) + (float(s) + 0.5f) / steps) * width;
+                xyz += cie_xyz(l) * (width / steps);
+            }
+            m[bin] = xyzToRgb * xyz;
+            white += m[bin];
+        }
+
+        for (glm::vec3& column : m)
+            column /= white;
+        return m;
+    }();
+
+    return matrix;
+}
@@ -0,0 +1,47 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file spectrum.hpp
+ * @brief Wavelength bins of the spectral mode and their
+ *        conversion to RGB
+ *********************************************************/
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <array>
+
+
+// Bins evenly covering the visible range, multiple of 4 so the shader
+//  evaluates them in vec4 groups (SPECTRAL_GROUPS in ray_marching.glsl)
+#define SPECTRAL_BINS 8
+#define SPECTRAL_MIN_WAVELENGTH 390.0f  ///< [nm]
+#define SPECTRAL_MAX_WAVELENGTH 710.0f  ///< [nm]
+
+// Wavelengths the RGB Rayleigh coefficients are given for, e.g., the Earth
+//  preset (5.8, 13.5, 33.1) * 1e-3 km^-1
+#define RGB_WAVELENGTHS glm::vec3(680.0f, 550.0f, 440.0f)
+
+static_assert(SPECTRAL_BINS % 4 == 0, "Bins are grouped by four in the shader");
+
+
+/** @return Center wavelength of the bin [nm] */
+float spectral_wavelength(int bin);
+
+/**
+ * @brief Rayleigh scattering coefficient of each bin, interpolated from the
+ *  RGB coefficients as a power law of the wavelength (lambda^-4 for
+ *  physical values), piecewise between the RGB wavelengths
+ * @param beta_R Rayleigh scattering coefficient for RGB_WAVELENGTHS
+ * @param beta Coefficient of each bin
+ */
+void rayleigh_spectrum(const glm::vec3& beta_R, float beta[SPECTRAL_BINS]);
+
+/**
+ * @brief Conversion of radiance in the bins to linear RGB, the CIE 1931
+ *  matching functions integrated over each bin and converted from XYZ to 
+ *  sRGB primaries. Normalized so the flat spectrum of ones maps to (1, 1, 1),
+ *  i.e., the sun of the intensity I_sun stays as bright as in the RGB mode.
+ *  Computed once.
+ * @return RGB contribution of each bin
+ */
+const std::array<glm::vec3, SPECTRAL_BINS>& spectral_to_rgb();
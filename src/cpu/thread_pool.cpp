@@ -0,0 +1,58 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file thread_pool.cpp
+ * @brief Persistent worker threads for CPU side precomputation
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "thread_pool.hpp"
+
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    threads = std::max(1u, threads);
+    for (unsigned t = 0; t < threads; ++t)
+        m_workers.emplace_back(&ThreadPool::worker_loop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+ThreadPool& ThreadPool::global()
+{
+    static ThreadPool pool(std::thread::hardware_concurrency());
+    return pool;
+}
+
+void ThreadPool::worker_loop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { 
+                return m_stop || !m_tasks.empty(); 
+            });
+
+            // Queue is drained before stopping
+            if (m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+
+        task();
+    }
+}
+
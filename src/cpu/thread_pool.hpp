@@ -0,0 +1,81 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file thread_pool.hpp
+ * @brief Persistent worker threads for CPU side precomputation
+ *********************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * @brief Fixed number of worker threads executing submitted tasks in FIFO
+ *  order. Tasks may submit further tasks, but must not block on their
+ *  results, see parallel_for for a safe way to split work.
+ *
+ *  Usage example:
+ *      std::future<int> answer = ThreadPool::global().submit([]() { 
+ *          return 42; 
+ *      });
+ *      // ... other work ...
+ *      int a = answer.get();
+ */
+class ThreadPool
+{
+public:
+    /** @param threads Number of workers, at least one */
+    explicit ThreadPool(unsigned threads);
+
+    /** @brief Finishes all queued tasks and joins the workers */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queues a callable for execution on one of the workers
+     * @return Future holding the result, or the exception thrown
+     */
+    template<typename Fn>
+    std::future<std::invoke_result_t<Fn>> submit(Fn&& fn)
+    {
+        using Result = std::invoke_result_t<Fn>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<Fn>(fn));
+        std::future<Result> result = task->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.emplace([task]() { (*task)(); });
+        }
+        m_condition.notify_one();
+
+        return result;
+    }
+
+    unsigned size() const { return static_cast<unsigned>(m_workers.size()); }
+
+    /** @brief Pool shared by the whole application, one worker per core */
+    static ThreadPool& global();
+
+private:
+    void worker_loop();
+
+private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop = false;
+};
+
@@ -0,0 +1,73 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file transmittance_lut.cpp
+ * @brief Precomputed transmittance towards the sun
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "transmittance_lut.hpp"
+
+
+TransmittanceLUT::TransmittanceLUT(int width, int height)
+  : m_R_e(0.0f), m_R_a(0.0f)
+{
+    m_table.resize(width, height);
+}
+
+void TransmittanceLUT::bake(const AtmosphereParams& p, int samples)
+{
+    m_R_e = p.R_e;
+    m_R_a = p.R_a;
+    const float H_a = p.R_a - p.R_e;
+
+    for (int y = 0; y < m_table.height; ++y)
+    {
+        // Texel center lies exactly on the parameter y / (height - 1)
+        float v = float(y) / float(m_table.height - 1);
+        float r = p.R_e + v * v * H_a;
+
+        // Cosine of the horizon, rays below it hit the ground
+        float mu_horizon = -std::sqrt(glm::max(0.0f, 1.0f - (p.R_e * p.R_e) / (r * r)));
+
+        for (int x = 0; x < m_table.width; ++x)
+        {
+            float mu_s = float(x) / float(m_table.width - 1) * 2.0f - 1.0f;
+
+            if (mu_s < mu_horizon)
+            {
+                m_table.at(x, y) = glm::vec3(0.0f);
+                continue;
+            }
+
+            glm::vec3 o(0.0f, r, 0.0f);
+            glm::vec3 d(std::sqrt(glm::max(0.0f, 1.0f - mu_s * mu_s)), mu_s, 0.0f);
+            float len = ray_sphere_intersection(o, d, p.R_a).y;
+
+            m_table.at(x, y) = extinction(p, optical_depth(p, o, d, len, samples));
+        }
+    }
+}
+
+glm::vec3 TransmittanceLUT::lookup(float r, float mu_s) const
+{
+    float h = glm::clamp((r - m_R_e) / (m_R_a - m_R_e), 0.0f, 1.0f);
+
+    return m_table.sample(to_texel_center(mu_s * 0.5f + 0.5f, m_table.width),
+                          to_texel_center(std::sqrt(h), m_table.height));
+}
+
+bool TransmittanceLUT::blends_horizon(float r, float mu_s) const
+{
+    float h = glm::clamp((r - m_R_e) / (m_R_a - m_R_e), 0.0f, 1.0f);
+
+    // The lower of the filtered rows has the higher horizon
+    float v = std::floor(std::sqrt(h) * float(m_table.height - 1)) / 
+              float(m_table.height - 1);
+    float r_0 = m_R_e + v * v * (m_R_a - m_R_e);
+    float mu_horizon = -std::sqrt(glm::max(0.0f, 1.0f - (m_R_e * m_R_e) / (r_0 * r_0)));
+
+    // First column at or above the horizon, as stored by bake()
+    float x = std::ceil((mu_horizon * 0.5f + 0.5f) * float(m_table.width - 1));
+    return mu_s < x / float(m_table.width - 1) * 2.0f - 1.0f;
+}
+
@@ -0,0 +1,65 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file transmittance_lut.hpp
+ * @brief Precomputed transmittance towards the sun
+ *********************************************************/
+
+#pragma once
+
+#include "atmosphere_model.hpp"
+#include "lut2d.hpp"
+
+
+#define TRANSMITTANCE_LUT_WIDTH   256   ///< Resolution of cosine of sun zenith
+#define TRANSMITTANCE_LUT_HEIGHT  64    ///< Resolution of altitude
+#define TRANSMITTANCE_LUT_SAMPLES 64    ///< Samples along each light ray
+
+
+/**
+ * @brief Table of transmittance from a point in the atmosphere towards
+ *  the top of the atmosphere, indexed by the altitude of the point and
+ *  the cosine of the sun zenith angle at that point. Replaces the light
+ *  (secondary) ray integration in the shader.
+ *
+ *  Parametrization, mirrored in the shader:
+ *      u = mu_s * 0.5 + 0.5
+ *      v = sqrt(altitude / (R_a - R_e))
+ *  both mapped to texel centers.
+ */
+class TransmittanceLUT
+{
+public:
+    TransmittanceLUT(int width = TRANSMITTANCE_LUT_WIDTH,
+                     int height = TRANSMITTANCE_LUT_HEIGHT);
+
+    /**
+     * @brief (Re)computes the table for the properties of the atmosphere
+     * @param p Properties of the atmosphere
+     * @param samples Number of samples along each light ray
+     */
+    void bake(const AtmosphereParams& p,
+              int samples = TRANSMITTANCE_LUT_SAMPLES);
+
+    /**
+     * @brief Transmittance towards the sun, for the params last baked with
+     * @param r Distance of the point from the center of the planet
+     * @param mu_s Cosine of the sun zenith angle at the point
+     */
+    glm::vec3 lookup(float r, float mu_s) const;
+
+    /**
+     * @brief Whether the filtered lookup blends in the zeros stored for
+     *  the rays hitting the ground, i.e., the ray is about one texel above
+     *  the horizon or lower
+     * @param r Distance of the point from the center of the planet
+     * @param mu_s Cosine of the zenith angle of the ray at the point
+     */
+    bool blends_horizon(float r, float mu_s) const;
+
+    const LUT2D& table() const { return m_table; }
+
+private:
+    LUT2D m_table;
+    float m_R_e, m_R_a;
+};
+
@@ -3,8 +3,8 @@
  * @author Martin Smutny, xsmutn13@stud.fit.vutbr.cz
  * @date April, 2021
  * @file buffer.cpp
- * @brief OpenGL Vertex Buffer Object and Index Buffer
- *        Object abstractions
+ * @brief OpenGL Vertex Buffer Object, Index Buffer
+ *        Object and Uniform Buffer Object abstractions
  *********************************************************/
 
 #include "core/pch.hpp"
@@ -145,6 +145,44 @@ void IndexBuffer::unbind() const
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+// ----------------------------------------------------------------------------
+// Uniform Buffer
+// ----------------------------------------------------------------------------
+
+UniformBuffer::UniformBuffer(uint32_t size)
+{
+#if OPENGL_VERSION >= 45
+    glCreateBuffers(1, &m_id);
+    glNamedBufferStorage(m_id, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+#else
+    glGenBuffers(1, &m_id);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+#endif
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    glDeleteBuffers(1, &m_id);
+}
+
+void UniformBuffer::set_data(uint32_t size, const void* data, int32_t offset) const
+{
+#if OPENGL_VERSION >= 45
+    glNamedBufferSubData(m_id, offset, size, data);
+#else
+    glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+#endif
+}
+
+void UniformBuffer::bind_base(uint32_t binding) const
+{
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_id);
+}
+
 // ----------------------------------------------------------------------------
 // Util
 // ----------------------------------------------------------------------------
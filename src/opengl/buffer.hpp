@@ -3,8 +3,8 @@
  * @author Martin Smutny, xsmutn13@stud.fit.vutbr.cz
  * @date April, 2021
  * @file buffer.hpp
- * @brief OpenGL Vertex Buffer Object and Index Buffer
- *        Object abstractions
+ * @brief OpenGL Vertex Buffer Object, Index Buffer
+ *        Object and Uniform Buffer Object abstractions
  *********************************************************/
 
 #pragma once
@@ -331,3 +331,37 @@ private:
 };
 
 
+/**
+ * @brief Uniform block data shared by the programs through a binding point,
+ *  see Shader::set_uniform_block. Data is laid out by the std140 rules.
+ */
+class UniformBuffer
+{
+public:
+    /**
+     * @brief Creates the buffer object with storage for updates.
+     * @param size Size of the block in bytes.
+     */
+    explicit UniformBuffer(uint32_t size);
+    ~UniformBuffer();
+
+    // Owns the buffer object, deleted in the destructor
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    /**
+     * @brief Uploads new data to the buffer.
+     * @param size Size of the data to be uploaded in bytes.
+     * @param data New data to be uploaded.
+     * @param offset Where the replacement will begin in the data store.
+     */
+    void set_data(uint32_t size, const void* data, int32_t offset = 0) const;
+
+    /** @brief Binds the buffer to the indexed uniform binding point */
+    void bind_base(uint32_t binding) const;
+
+    uint32_t ID() const { return m_id; }
+
+private:
+    uint32_t m_id;
+};
@@ -0,0 +1,112 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file framebuffer.cpp
+ * @brief OpenGL Framebuffer Object abstraction
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "framebuffer.hpp"
+
+
+Framebuffer::Framebuffer()
+{
+    DERR("Framebuffer def CONSTR");
+
+#if OPENGL_VERSION >= 45
+    glCreateFramebuffers(1, &m_id);
+#else
+    glGenFramebuffers(1, &m_id);
+#endif
+}
+
+Framebuffer::~Framebuffer()
+{
+    DERR("Framebuffer def DESTR");
+
+    glDeleteFramebuffers(1, &m_id);
+}
+
+void Framebuffer::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_id);
+}
+
+void Framebuffer::unbind(uint32_t previous) const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, previous);
+}
+
+void Framebuffer::attach_color(const Texture2D& texture, uint32_t attachment)
+{
+#if OPENGL_VERSION >= 45
+    glNamedFramebufferTexture(m_id, GL_COLOR_ATTACHMENT0 + attachment,
+                              texture.ID(), 0);
+#else
+    bind();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + attachment,
+                           GL_TEXTURE_2D, texture.ID(), 0);
+    unbind();
+#endif
+
+    if (!is_complete())
+        LOG_ERR("| Error::Framebuffer: Incomplete after attaching a texture");
+}
+
+void Framebuffer::attach_color_layer(const Texture3D& texture, int layer,
+                                     uint32_t attachment)
+{
+#if OPENGL_VERSION >= 45
+    glNamedFramebufferTextureLayer(m_id, GL_COLOR_ATTACHMENT0 + attachment,
+                                   texture.ID(), 0, layer);
+#else
+    bind();
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + attachment,
+                              texture.ID(), 0, layer);
+    unbind();
+#endif
+}
+
+void Framebuffer::attach_color_face(const TextureCube& texture, int face, 
+                                    uint32_t attachment)
+{
+#if OPENGL_VERSION >= 45
+    // Faces are the layers of a cube map in the direct state access
+    glNamedFramebufferTextureLayer(m_id, GL_COLOR_ATTACHMENT0 + attachment,
+                                   texture.ID(), 0, face);
+#else
+    bind();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + attachment,
+                           GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, texture.ID(), 0);
+    unbind();
+#endif
+}
+
+void Framebuffer::set_draw_buffers(int count)
+{
+    std::vector<GLenum> buffers(count);
+    for (int i = 0; i < count; ++i)
+        buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+
+#if OPENGL_VERSION >= 45
+    glNamedFramebufferDrawBuffers(m_id, count, buffers.data());
+#else
+    bind();
+    glDrawBuffers(count, buffers.data());
+    unbind();
+#endif
+}
+
+bool Framebuffer::is_complete() const
+{
+#if OPENGL_VERSION >= 45
+    return glCheckNamedFramebufferStatus(m_id, GL_FRAMEBUFFER) == 
+           GL_FRAMEBUFFER_COMPLETE;
+#else
+    bind();
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == 
+                    GL_FRAMEBUFFER_COMPLETE;
+    unbind();
+    return complete;
+#endif
+}
+
@@ -0,0 +1,83 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file framebuffer.hpp
+ * @brief OpenGL Framebuffer Object abstraction
+ *********************************************************/
+
+#pragma once
+
+#include "texture2d.hpp"
+#include "texture3d.hpp"
+#include "texture_cube.hpp"
+
+
+/**
+ * @brief Framebuffer object rendering into textures. Only references 
+ *  attached textures, which have to outlive the framebuffer.
+ *
+ *  Usage example:
+ *      Texture2D tex(false);
+ *      tex.set_internal_format(GL_RGBA16F);
+ *      tex.upload((const float*)nullptr, w, h);  // allocate storage
+ *
+ *      Framebuffer fbo;
+ *      fbo.attach_color(tex);
+ *
+ *      fbo.bind();
+ *      glViewport(0, 0, w, h);
+ *      // draw calls
+ *      fbo.unbind();
+ */
+class Framebuffer
+{
+public:
+    Framebuffer();
+    ~Framebuffer();
+
+    void bind() const;
+
+    // Binds back the framebuffer 'previous', the default one by default
+    void unbind(uint32_t previous = 0) const;
+
+    /**
+     * @brief Attaches the texture as a color attachment
+     * @param texture Texture with already allocated storage
+     * @param attachment Index of the color attachment
+     */
+    void attach_color(const Texture2D& texture, uint32_t attachment = 0);
+
+    /**
+     * @brief Attaches a single layer of the 3D texture as a color attachment,
+     *  meant to be swapped each pass, hence does not check completeness
+     * @param texture Texture with already allocated storage
+     * @param layer Index of the layer (depth slice)
+     * @param attachment Index of the color attachment
+     */
+    void attach_color_layer(const Texture3D& texture, int layer, 
+                            uint32_t attachment = 0);
+
+    /**
+     * @brief Attaches a single face of the cube map as a color attachment,
+     *  meant to be swapped each pass, hence does not check completeness
+     * @param texture Texture with already allocated storage
+     * @param face Index of the face, +X, -X, +Y, -Y, +Z, -Z
+     * @param attachment Index of the color attachment
+     */
+    void attach_color_face(const TextureCube& texture, int face, 
+                           uint32_t attachment = 0);
+
+    /**
+     * @brief Enables rendering into the first 'count' color attachments,
+     *  fragment outputs are matched by their location
+     */
+    void set_draw_buffers(int count);
+
+    // @return Whether the framebuffer can be rendered into
+    bool is_complete() const;
+
+    uint32_t ID() const { return m_id; }
+
+private:
+    uint32_t m_id;    ///< Framebuffer ID reference
+};
+
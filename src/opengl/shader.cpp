@@ -20,6 +20,11 @@ Shader::Shader(const char *vert_src, const char *frag_src, const char *geom_src)
     compile(vert_src, frag_src, geom_src);
 }
 
+Shader::Shader(const char *comp_src)
+{
+    compile_compute(comp_src);
+}
+
 void Shader::use()
 {
     glUseProgram(m_id);
@@ -29,9 +34,11 @@ void Shader::use()
 uint32_t Shader::create_shader(const char *source, uint32_t type)
 {
     std::string text = load_file(source);
-    const char* text_c = text.data();
 
+    std::set<std::string> included = { source };
+    resolve_includes(text, source, included);
     fix_version(text);
+    const char* text_c = text.data();
 
     GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &text_c, nullptr);
@@ -81,6 +88,21 @@ void Shader::compile(const char *vert_src, const char *frag_src, const char *geo
         glDetachShader(m_id, sh_geom);
 }
 
+void Shader::compile_compute(const char *comp_src)
+{
+    LOG_INFO("Compiling sources: " << comp_src);
+    GLuint sh_comp = create_shader(comp_src, GL_COMPUTE_SHADER);
+
+    m_id = glCreateProgram();
+    glAttachShader(m_id, sh_comp);
+
+    glLinkProgram(m_id);
+    check_errors(m_id, LINK_ERRORS);
+
+    glDeleteShader(sh_comp);
+    glDetachShader(m_id, sh_comp);
+}
+
 void Shader::set_float(const char *name, float value)
 {
     glUniform1f(glGetUniformLocation(m_id, name), value);
@@ -101,6 +123,11 @@ void Shader::set_vec2(const char *name, const glm::vec2 &value)
     glUniform2f(glGetUniformLocation(m_id, name), value.x, value.y);
 }
 
+void Shader::set_ivec2(const char *name, const glm::ivec2 &value)
+{
+    glUniform2i(glGetUniformLocation(m_id, name), value.x, value.y);
+}
+
 void Shader::set_vec3(const char *name, float v0, float v1, float v2)
 {
     glUniform3f(glGetUniformLocation(m_id, name), v0, v1, v2);
@@ -134,6 +161,13 @@ void Shader::set_mat4(const char *name, const glm::mat4 &matrix)
                        glm::value_ptr(matrix));
 }
 
+void Shader::set_uniform_block(const char *name, uint32_t binding)
+{
+    uint32_t index = glGetUniformBlockIndex(m_id, name);
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(m_id, index, binding);
+}
+
 void Shader::check_errors(uint32_t object, int type)
 {
     int success;
@@ -170,6 +204,54 @@ void Shader::check_errors(uint32_t object, int type)
     }
 }
 
+void Shader::resolve_includes(std::string& code, const char* source,
+                              std::set<std::string>& included)
+{
+    // Included files are relative to the directory of the including file
+    std::string path = source;
+    size_t slash = path.find_last_of('/');
+    std::string dir = slash != std::string::npos ? path.substr(0, slash + 1) : "";
+
+    const std::string directive = "#include";
+    size_t pos = 0;
+    while (pos < code.length())
+    {
+        size_t endl = code.find('\n', pos);
+        if (endl == std::string::npos)
+            endl = code.length();
+
+        // Directive only at the start of a line, after any whitespace
+        size_t first = code.find_first_not_of(" \t", pos);
+        if (first >= endl || code.compare(first, directive.length(), directive) != 0)
+        {
+            pos = endl + 1;
+            continue;
+        }
+
+        size_t open = code.find('"', first);
+        size_t close = open != std::string::npos ? code.find('"', open + 1) 
+                                                 : std::string::npos;
+        if (close == std::string::npos || close > endl)
+        {
+            LOG_ERR("| Error::Shader: Malformed include in " << source);
+            code.erase(pos, endl - pos);
+            continue;
+        }
+
+        std::string name = dir + code.substr(open + 1, close - open - 1);
+
+        // Every file is included once, which also stops include cycles
+        std::string text;
+        if (included.insert(name).second)
+        {
+            text = load_file(name.c_str());
+            resolve_includes(text, name.c_str(), included);
+        }
+        code.replace(pos, endl - pos, text);
+        pos += text.length();
+    }
+}
+
 void Shader::fix_version(std::string& code)
 {
     std::string ver_str = GLSL_VERSION_STR;
@@ -36,6 +36,16 @@ public:
                  const char* frag_src, 
                  const char* geom_src = nullptr);
 
+    /**
+     * @brief Creates and compiles a compute shader program, needs OpenGL 4.3
+     * @param comp_src Contents of compute shader source file
+     */
+    explicit Shader(const char* comp_src);
+
+    /** @brief Creates and compiles a compute shader program 
+     *  @param See compute Shader constructor */
+    void compile_compute(const char* comp_src);
+
     /** @brief Activate shader program */
     void use();
 
@@ -72,6 +82,14 @@ public:
     void set_vec2(const char* name,
                   const glm::vec2& value);
 
+    /**
+     * @brief Set integer value of an ivec2 uniform variable of an ACTIVE program
+     * @param name Name of the variable
+     * @param value GLM ivec2 value
+     */
+    void set_ivec2(const char* name,
+                   const glm::ivec2& value);
+
     /**
      * @brief Set float value of a vec3 uniform variable of an ACTIVE program
      * @param name Name of the variable
@@ -123,6 +141,15 @@ public:
      */
     void set_mat4(const char* name,
                   const glm::mat4& matrix);
+
+    /**
+     * @brief Assigns a uniform block of the program to a binding point,
+     *  the program does not need to be active
+     * @param name Name of the uniform block
+     * @param binding Binding point, see UniformBuffer::bind_base
+     */
+    void set_uniform_block(const char* name,
+                           uint32_t binding);
  
 private:
  
@@ -141,6 +168,17 @@ private:
      */
     void check_errors(uint32_t object, int type);
 
+    /**
+     * @brief Replaces every #include "file" directive at the start of a line
+     *  with contents of the file, relative to the directory of the including
+     *  source. Files already included are skipped.
+     * @param code Loaded GLSL shader code
+     * @param source Path of the loaded shader source file
+     * @param included Paths of the files included so far
+     */
+    void resolve_includes(std::string& code, const char* source,
+                          std::set<std::string>& included);
+
     /**
      * @brief Forces shader code to CURRENT OpenGL version according to 
      *  GLSL_VERSION_STR and GLSL_PROFILE defined in pch.hpp
@@ -144,6 +144,11 @@ void Texture2D::bind_unit(uint32_t unit) const
     glBindTextureUnit(unit, m_id);
 }
 
+void Texture2D::bind_image(uint32_t unit, uint32_t access) const
+{
+    glBindImageTexture(unit, m_id, 0, GL_FALSE, 0, access, m_internal_format);
+}
+
 void Texture2D::set_repeat()
 {
     set_custom_wrap(GL_REPEAT);
@@ -74,6 +74,14 @@ public:
 	 */
 	void bind_unit(uint32_t unit) const;
 
+    /**
+     * @brief Bind the first level to the image unit for load and store
+     *  in shaders, needs OpenGL 4.2
+     * @param unit Number of the image unit
+     * @param access GL_READ_ONLY, GL_WRITE_ONLY or GL_READ_WRITE
+     */
+    void bind_image(uint32_t unit, uint32_t access) const;
+
     /**
      * @brief Activates texture unit 'unit' globally.
      */
@@ -0,0 +1,115 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file texture3d.cpp
+ * @brief OpenGL 3D texture abstraction
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "texture3d.hpp"
+
+
+Texture3D::Texture3D()
+    : m_width(0),
+      m_height(0),
+      m_depth(0),
+      m_internal_format(GL_RGB32F),
+      m_image_format(GL_RGB),
+      m_filterMin(GL_LINEAR),
+      m_filterMag(GL_LINEAR)
+{
+    DERR("Texture3D def CONSTR");
+
+    init_texture();
+    set_filtering();
+    set_clamp_to_edge();
+}
+
+Texture3D::~Texture3D()
+{
+    DERR("Texture3D def DESTR");
+
+    glDeleteTextures(1, &m_id);
+}
+
+void Texture3D::upload(const float* data, int w, int h, int d)
+{
+    // Save the dimensions
+    m_width = w;
+    m_height = h;
+    m_depth = d;
+
+    bind();
+
+    glTexImage3D(GL_TEXTURE_3D,         // texture type
+                 0,                     // level
+                 m_internal_format,     // sized internal format
+                 m_width, m_height,     // dimensions
+                 m_depth,
+                 0,                     // border
+                 m_image_format,        // image format
+                 GL_FLOAT,              // image datatype
+                 data);                 // pointer to the image data
+}
+
+void Texture3D::bind() const
+{
+    glBindTexture(GL_TEXTURE_3D, m_id);
+}
+
+void Texture3D::unbind() const
+{
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void Texture3D::activate(uint32_t unit) const
+{
+    if (unit > 80)
+        LOG_WARN("Going over of the ActiveTexture maximum units supported");
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void Texture3D::set_clamp_to_edge()
+{
+#if OPENGL_VERSION >= 45
+    glTextureParameteri(m_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(m_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(m_id, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+#else
+    bind();
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+#endif
+}
+
+void Texture3D::set_filtering(uint32_t min_f, uint32_t mag_f)
+{
+    m_filterMin = min_f;
+    m_filterMag = mag_f;
+
+    set_filtering();
+}
+
+void Texture3D::init_texture()
+{
+#if OPENGL_VERSION >= 45
+    glCreateTextures(GL_TEXTURE_3D, 1, &m_id);
+#else
+    glGenTextures(1, &m_id);
+    bind();
+#endif
+}
+
+void Texture3D::set_filtering()
+{
+#if OPENGL_VERSION >= 45
+    glTextureParameteri(m_id, GL_TEXTURE_MIN_FILTER, m_filterMin);
+    glTextureParameteri(m_id, GL_TEXTURE_MAG_FILTER, m_filterMag);
+#else
+    bind();
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, m_filterMin);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, m_filterMag);
+#endif
+}
+
@@ -0,0 +1,78 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file texture3d.hpp
+ * @brief OpenGL 3D texture abstraction
+ *********************************************************/
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+
+/**
+ * @brief 3D texture without mipmaps, meant for precomputed tables.
+ *  Defaults: Image format: RGB, internal format: RGB32F, linear filtering,
+ *  clamp to edge.
+ */
+class Texture3D
+{
+public:
+	/**
+	 * @brief Creates an empty 3D texture object.
+     *        Expects data to be uploaded later.
+	 */
+	Texture3D();
+
+	~Texture3D();
+
+	/**
+	 * @brief Upload FLOAT data to the texture object, (re)allocates storage.
+	 * @param data Data in the image format as already set.
+     * @param width Width of the data
+     * @param height Height of the data
+     * @param depth Depth of the data
+ 	 */
+    void upload(const float* data, int width, int height, int depth);
+
+	/**
+ 	 * @brief Bind the texture object
+	 */
+	void bind() const;
+
+	void unbind() const;
+
+    /**
+     * @brief Activates texture unit 'unit' globally.
+     */
+    void activate(uint32_t unit) const;
+
+    //------------------------------------------------------------
+	// Setters
+	void set_internal_format(uint32_t f) { m_internal_format = f; }
+
+	void set_image_format(uint32_t f) { m_image_format = f; }
+
+    void set_clamp_to_edge();
+
+    void set_filtering(uint32_t min_f, uint32_t mag_f);
+
+    //------------------------------------------------------------
+	// Getters
+	uint32_t ID() const { return m_id; }
+
+	glm::uvec3 size() const { return glm::uvec3(m_width, m_height, m_depth); }
+
+private:
+    void init_texture();
+
+    void set_filtering();
+
+private:
+	uint32_t m_id;
+
+	uint32_t m_width, m_height, m_depth;
+	uint32_t m_internal_format, m_image_format;
+
+    uint32_t m_filterMin, m_filterMag;
+};
+
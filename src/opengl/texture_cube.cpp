@@ -0,0 +1,113 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file texture_cube.cpp
+ * @brief OpenGL cube map texture abstraction
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "texture_cube.hpp"
+
+
+TextureCube::TextureCube()
+    : m_size(0),
+      m_internal_format(GL_RGBA16F),
+      m_image_format(GL_RGBA),
+      m_filterMin(GL_LINEAR),
+      m_filterMag(GL_LINEAR)
+{
+    init_texture();
+    set_filtering();
+    set_clamp_to_edge();
+
+    // Global state, core since OpenGL 3.2
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+}
+
+TextureCube::~TextureCube()
+{
+    glDeleteTextures(1, &m_id);
+}
+
+void TextureCube::upload(const float* data, int size)
+{
+    m_size = size;
+
+    // Floats of a face in the image format
+    int channels = m_image_format == GL_RGBA ? 4 : 3;
+    size_t faceFloats = size_t(size) * size * channels;
+
+    bind();
+    for (int face = 0; face < 6; ++face)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, // face
+                     0,                                     // level
+                     m_internal_format,                     // sized internal format
+                     m_size, m_size,                        // dimensions
+                     0,                                     // border
+                     m_image_format,                        // image format
+                     GL_FLOAT,                              // image datatype
+                     data ? data + face * faceFloats : nullptr);
+    }
+}
+
+void TextureCube::bind() const
+{
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_id);
+}
+
+void TextureCube::unbind() const
+{
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+void TextureCube::activate(uint32_t unit) const
+{
+    if (unit > 80)
+        LOG_WARN("Going over of the ActiveTexture maximum units supported");
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void TextureCube::set_clamp_to_edge()
+{
+#if OPENGL_VERSION >= 45
+    glTextureParameteri(m_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(m_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(m_id, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+#else
+    bind();
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+#endif
+}
+
+void TextureCube::set_filtering(uint32_t min_f, uint32_t mag_f)
+{
+    m_filterMin = min_f;
+    m_filterMag = mag_f;
+
+    set_filtering();
+}
+
+void TextureCube::init_texture()
+{
+#if OPENGL_VERSION >= 45
+    glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &m_id);
+#else
+    glGenTextures(1, &m_id);
+    bind();
+#endif
+}
+
+void TextureCube::set_filtering()
+{
+#if OPENGL_VERSION >= 45
+    glTextureParameteri(m_id, GL_TEXTURE_MIN_FILTER, m_filterMin);
+    glTextureParameteri(m_id, GL_TEXTURE_MAG_FILTER, m_filterMag);
+#else
+    bind();
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, m_filterMin);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, m_filterMag);
+#endif
+}
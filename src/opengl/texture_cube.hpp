@@ -0,0 +1,78 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file texture_cube.hpp
+ * @brief OpenGL cube map texture abstraction
+ *********************************************************/
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+
+/**
+ * @brief Cube map texture without mipmaps, meant to be rendered into.
+ *  Faces are indexed in the order of GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+ *  i.e. +X, -X, +Y, -Y, +Z, -Z.
+ *  Defaults: Image format: RGBA, internal format: RGBA16F, linear filtering,
+ *  clamp to edge, seamless filtering across the faces.
+ */
+class TextureCube
+{
+public:
+	/**
+	 * @brief Creates an empty cube map texture object.
+     *        Expects storage to be allocated later.
+	 */
+	TextureCube();
+
+	~TextureCube();
+
+	/**
+	 * @brief Upload FLOAT data to all the faces, (re)allocates storage.
+	 * @param data Data of each face one after another in the image format 
+     *             as already set, or nullptr to only allocate
+     * @param size Width and height of each face
+ 	 */
+    void upload(const float* data, int size);
+
+	/**
+ 	 * @brief Bind the texture object
+	 */
+	void bind() const;
+
+	void unbind() const;
+
+    /**
+     * @brief Activates texture unit 'unit' globally.
+     */
+    void activate(uint32_t unit) const;
+
+    //------------------------------------------------------------
+	// Setters
+	void set_internal_format(uint32_t f) { m_internal_format = f; }
+
+	void set_image_format(uint32_t f) { m_image_format = f; }
+
+    void set_filtering(uint32_t min_f, uint32_t mag_f);
+
+    //------------------------------------------------------------
+	// Getters
+	uint32_t ID() const { return m_id; }
+
+	int size() const { return m_size; }
+
+private:
+    void init_texture();
+
+    void set_clamp_to_edge();
+
+    void set_filtering();
+
+private:
+	uint32_t m_id;
+
+	int m_size;
+	uint32_t m_internal_format, m_image_format;
+
+    uint32_t m_filterMin, m_filterMag;
+};
@@ -0,0 +1,56 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file timer_query.cpp
+ * @brief OpenGL timer query abstraction
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "timer_query.hpp"
+
+
+TimerQuery::TimerQuery()
+{
+    glGenQueries(TIMER_QUERY_COUNT, m_ids);
+}
+
+TimerQuery::~TimerQuery()
+{
+    glDeleteQueries(TIMER_QUERY_COUNT, m_ids);
+}
+
+void TimerQuery::begin()
+{
+    m_active = m_pending < TIMER_QUERY_COUNT;
+    if (m_active)
+        glBeginQuery(GL_TIME_ELAPSED, 
+                     m_ids[(m_oldest + m_pending) % TIMER_QUERY_COUNT]);
+}
+
+void TimerQuery::end()
+{
+    if (!m_active)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    m_active = false;
+    ++m_pending;
+}
+
+bool TimerQuery::poll(double& ms)
+{
+    if (m_pending == 0)
+        return false;
+
+    GLint available = 0;
+    glGetQueryObjectiv(m_ids[m_oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(m_ids[m_oldest], GL_QUERY_RESULT, &ns);
+    ms = double(ns) * 1e-6;
+
+    m_oldest = (m_oldest + 1) % TIMER_QUERY_COUNT;
+    --m_pending;
+    return true;
+}
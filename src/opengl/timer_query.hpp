@@ -0,0 +1,53 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @file timer_query.hpp
+ * @brief OpenGL timer query abstraction
+ *********************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+
+#define TIMER_QUERY_COUNT 4     ///< Frames measured before the results are read
+
+
+/**
+ * @brief Measures the GPU time of the commands between begin() and end()
+ *  with GL_TIME_ELAPSED queries. Results arrive a few frames late, the
+ *  queries are kept in a ring and read only once available, so the CPU
+ *  never waits for the GPU. Timer queries cannot be nested.
+ *
+ *  Usage example:
+ *      timer.begin();
+ *      // draw calls
+ *      timer.end();
+ *
+ *      double ms;
+ *      while (timer.poll(ms))
+ *          // oldest finished measurement
+ */
+class TimerQuery
+{
+public:
+    TimerQuery();
+    ~TimerQuery();
+
+    /** @brief Starts measuring, skipped while all the queries are pending */
+    void begin();
+
+    void end();
+
+    /**
+     * @brief Reads the oldest finished measurement
+     * @param ms GPU time in milliseconds
+     * @return Whether any measurement was available
+     */
+    bool poll(double& ms);
+
+private:
+    uint32_t m_ids[TIMER_QUERY_COUNT];
+    int m_oldest = 0;       ///< Index of the oldest pending query
+    int m_pending = 0;      ///< Ended queries not yet read
+    bool m_active = false;  ///< Whether begin() started a query
+};
@@ -0,0 +1,1276 @@
+/**********************************************************
+ * < Interactive Atmospheric Scattering >
+ * @author Martin Smutny, xsmutn13@stud.fit.vutbr.cz
+ * @date April, 2021
+ * @file atmosphere.cpp
+ * @brief Representation of an atmoshpere.
+ *********************************************************/
+
+#include "core/pch.hpp"
+#include "atmosphere.hpp"
+
+
+// Pixel of each 2x2 block shaded in consecutive frames, diagonal pairs 
+//  first, so that the half mode alternates two checkerboards
+static const glm::ivec2 temporalLattices[4] = {
+    { 0, 0 }, { 1, 1 }, { 1, 0 }, { 0, 1 }
+};
+
+/** 
+ * @return View matrix from the origin towards a face of a cube map, in the
+ *  order of GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, with the up vectors of
+ *  the cube map conventions (the faces are seen from the inside)
+ */
+static glm::mat4 cubemap_faceView(int face)
+{
+    static const glm::vec3 dirs[6] = {
+        { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f },
+        { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f }
+    };
+    static const glm::vec3 ups[6] = {
+        { 0.f, -1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f },
+        { 0.f, 0.f, -1.f }, { 0.f, -1.f, 0.f }, { 0.f, -1.f, 0.f }
+    };
+    return glm::lookAt(glm::vec3(0.f), dirs[face], ups[face]);
+}
+
+Atmosphere::Atmosphere(const std::shared_ptr<Shader>& drawMeshProgram,
+                       Mesh* sphereModel)
+    : m_drawMeshProgram(drawMeshProgram),
+      m_sphereModel(sphereModel)
+{
+    init_dependencies();
+    set_defaults();
+
+    m_atmosphereProgram = std::make_unique<Shader>("shaders/draw_atmosphere.vert",
+                                                   "shaders/draw_atmosphere.frag");
+    m_precomputedProgram = std::make_unique<Shader>("shaders/draw_atmosphere.vert",
+                                            "shaders/draw_atmosphere_precomputed.frag");
+    m_skyViewProgram = std::make_unique<Shader>("shaders/fullscreen.vert",
+                                                "shaders/compute_sky_view.frag");
+    m_drawSkyViewProgram = std::make_unique<Shader>("shaders/draw_atmosphere.vert",
+                                            "shaders/draw_atmosphere_sky_view.frag");
+    m_analyticProgram = std::make_unique<Shader>("shaders/draw_atmosphere.vert",
+                                            "shaders/draw_atmosphere_analytic.frag");
+    m_domeProgram = std::make_unique<Shader>("shaders/draw_atmosphere_dome.vert",
+                                             "shaders/draw_atmosphere_dome.frag");
+    m_aerialProgram = std::make_unique<Shader>("shaders/fullscreen.vert",
+                                        "shaders/compute_aerial_perspective.frag");
+    m_drawReferenceProgram = std::make_unique<Shader>("shaders/fullscreen.vert",
+                                                  "shaders/draw_reference.frag");
+    m_resolveTemporalProgram = std::make_unique<Shader>("shaders/fullscreen.vert",
+                                                  "shaders/resolve_temporal.frag");
+    m_drawOffscreenProgram = std::make_unique<Shader>("shaders/draw_atmosphere.vert",
+                                            "shaders/draw_atmosphere_offscreen.frag");
+#if OPENGL_VERSION >= 43
+    m_computeProgram = std::make_unique<Shader>("shaders/compute_sky.comp");
+#endif
+
+    // Float RGB table, without mipmaps
+    m_transmittanceTexture = std::make_unique<Texture2D>(false);
+    m_transmittanceTexture->set_internal_format(GL_RGB32F);
+    m_transmittanceTexture->set_image_format(GL_RGB);
+
+    m_multipleScatteringTexture = std::make_unique<Texture2D>(false);
+    m_multipleScatteringTexture->set_internal_format(GL_RGB32F);
+    m_multipleScatteringTexture->set_image_format(GL_RGB);
+
+    m_groundIrradianceTexture = std::make_unique<Texture2D>(false);
+    m_groundIrradianceTexture->set_internal_format(GL_RGB32F);
+    m_groundIrradianceTexture->set_image_format(GL_RGB);
+
+    m_scatteringTexture = std::make_unique<Texture3D>();
+    m_mieScatteringTexture = std::make_unique<Texture3D>();
+
+    // Half float is enough for radiance and renderable in core profile
+    m_skyViewTexture = std::make_unique<Texture2D>(false);
+    m_skyViewTexture->set_internal_format(GL_RGBA16F);
+    m_skyViewTexture->set_image_format(GL_RGBA);
+    m_skyViewTexture->upload((const float*)nullptr, SKY_VIEW_WIDTH, SKY_VIEW_HEIGHT);
+    m_skyViewTexture->set_clamp_to_edge();
+    m_skyViewTexture->set_linear_filtering();
+
+    m_skyViewFramebuffer = std::make_unique<Framebuffer>();
+    m_skyViewFramebuffer->attach_color(*m_skyViewTexture);
+
+    m_skyViewSequenceTexture = std::make_unique<Texture3D>();
+    m_skyViewSequenceTexture->set_internal_format(GL_RGBA16F);
+    m_skyViewSequenceTexture->set_image_format(GL_RGBA);
+    m_skyViewSequenceTexture->upload(nullptr, SKY_VIEW_WIDTH, SKY_VIEW_HEIGHT,
+                                     SKY_VIEW_SEQUENCE_LAYERS);
+
+    m_skyViewSequenceFramebuffer = std::make_unique<Framebuffer>();
+
+    // Sized to the viewport in draw_offscreen, alpha marks the atmosphere
+    m_skyTexture = std::make_unique<Texture2D>(false);
+    m_skyTexture->set_internal_format(GL_RGBA16F);
+    m_skyTexture->set_image_format(GL_RGBA);
+    m_skyTexture->upload((const float*)nullptr, 1, 1);
+    m_skyTexture->set_clamp_to_edge();
+    m_skyTexture->set_filtering(GL_NEAREST, GL_NEAREST);
+
+    m_skyFramebuffer = std::make_unique<Framebuffer>();
+    m_skyFramebuffer->attach_color(*m_skyTexture);
+
+    m_latticeTexture = std::make_unique<Texture2D>(false);
+    m_latticeTexture->set_internal_format(GL_RGBA16F);
+    m_latticeTexture->set_image_format(GL_RGBA);
+    m_latticeTexture->upload((const float*)nullptr, 1, 1);
+    m_latticeTexture->set_clamp_to_edge();
+    m_latticeTexture->set_filtering(GL_NEAREST, GL_NEAREST);
+
+    m_latticeFramebuffer = std::make_unique<Framebuffer>();
+    m_latticeFramebuffer->attach_color(*m_latticeTexture);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        m_historyTextures[i] = std::make_unique<Texture2D>(false);
+        m_historyTextures[i]->set_internal_format(GL_RGBA16F);
+        m_historyTextures[i]->set_image_format(GL_RGBA);
+        m_historyTextures[i]->upload((const float*)nullptr, 1, 1);
+        m_historyTextures[i]->set_clamp_to_edge();
+        m_historyTextures[i]->set_linear_filtering();
+
+        m_historyFramebuffers[i] = std::make_unique<Framebuffer>();
+        m_historyFramebuffers[i]->attach_color(*m_historyTextures[i]);
+    }
+
+    m_fullscreenVao = std::make_unique<VertexArray>();
+    create_dome();
+
+    m_referenceTexture = std::make_unique<Texture2D>(false);
+    m_referenceTexture->set_internal_format(GL_RGB32F);
+    m_referenceTexture->set_image_format(GL_RGB);
+
+    m_iterationsTexture = std::make_unique<Texture2D>(false);
+    m_iterationsTexture->set_internal_format(GL_RG32F);
+    m_iterationsTexture->set_image_format(GL_RG);
+    m_iterationsTexture->upload((const float*)nullptr, ITERATION_STATS_WIDTH,
+                                ITERATION_STATS_HEIGHT);
+    m_iterationsTexture->set_filtering(GL_NEAREST, GL_NEAREST);
+
+    m_iterationsFramebuffer = std::make_unique<Framebuffer>();
+    m_iterationsFramebuffer->attach_color(*m_iterationsTexture);
+
+    m_aerialScatteringTexture = std::make_unique<Texture3D>();
+    m_aerialTransmittanceTexture = std::make_unique<Texture3D>();
+    for (Texture3D* texture : { m_aerialScatteringTexture.get(),
+                                m_aerialTransmittanceTexture.get() })
+    {
+        texture->set_internal_format(GL_RGBA16F);
+        texture->set_image_format(GL_RGBA);
+        texture->upload(nullptr, AERIAL_PERSPECTIVE_SIZE, AERIAL_PERSPECTIVE_SIZE,
+                        AERIAL_PERSPECTIVE_SIZE);
+    }
+
+    m_skySHBuffer = std::make_unique<UniformBuffer>(SKY_SH_COEFFICIENTS * 
+                                                    sizeof(glm::vec4));
+    m_drawMeshProgram->set_uniform_block("SkySH", SKY_SH_BINDING);
+
+    // Filled by tiles once the capture is enabled, see update_skyCubemap
+    m_skyCubemap = std::make_unique<TextureCube>();
+    m_skyCubemap->upload(nullptr, SKY_CUBEMAP_SIZE);
+    m_skyCubemapFramebuffer = std::make_unique<Framebuffer>();
+    m_skyCubemapTiles.resize(6 * SKY_CUBEMAP_TILES * SKY_CUBEMAP_TILES);
+
+    m_aerialFramebuffer = std::make_unique<Framebuffer>();
+    m_aerialFramebuffer->attach_color_layer(*m_aerialScatteringTexture, 0, 0);
+    m_aerialFramebuffer->attach_color_layer(*m_aerialTransmittanceTexture, 0, 1);
+    m_aerialFramebuffer->set_draw_buffers(2);
+    if (!m_aerialFramebuffer->is_complete())
+        LOG_ERR("Aerial perspective framebuffer is incomplete");
+}
+
+void Atmosphere::init_dependencies()
+{
+    m_params.depends(PRODUCT_MODEL_EARTH, { PARAM_EARTH_RADIUS });
+
+    // Optical properties along the rays, the sun is a lookup parameter
+    m_params.depends(PRODUCT_TRANSMITTANCE, 
+                     { PARAM_EARTH_RADIUS, PARAM_ATMOS_RADIUS, 
+                       PARAM_RAYLEIGH, PARAM_MIE });
+    // Isotropic approximation, without the phase function
+    m_params.depends(PRODUCT_MULTIPLE_SCATTERING, 
+                     { PARAM_EARTH_RADIUS, PARAM_ATMOS_RADIUS, 
+                       PARAM_RAYLEIGH, PARAM_MIE });
+    // Phase function is part of the multiple scattering
+    m_params.depends(PRODUCT_SCATTERING_TABLES, 
+                     { PARAM_EARTH_RADIUS, PARAM_ATMOS_RADIUS, 
+                       PARAM_RAYLEIGH, PARAM_MIE, PARAM_MIE_DIR,
+                       PARAM_SCATTERING_ORDERS });
+    // Whole sky around the viewer, ray marched with the current settings.
+    //  Covers all the sun angles and is scaled by the intensity when read.
+    m_params.depends(PRODUCT_SKY_VIEW_SEQUENCE, 
+                     { PARAM_EARTH_RADIUS, PARAM_ATMOS_RADIUS, 
+                       PARAM_RAYLEIGH, PARAM_MIE, PARAM_MIE_DIR,
+                       PARAM_SAMPLING });
+    // Any change but the sun, which is allowed to move slowly
+    m_params.depends(PRODUCT_TEMPORAL_HISTORY, 
+                     { PARAM_EARTH_RADIUS, PARAM_ATMOS_RADIUS, 
+                       PARAM_RAYLEIGH, PARAM_MIE, PARAM_MIE_DIR,
+                       PARAM_SAMPLING });
+    // All the sun angles, scaled by the intensity when read. Baked from 
+    //  the transmittance and multiple scattering tables once they are 
+    //  not stale, their params are a subset.
+    m_params.depends(PRODUCT_GROUND_IRRADIANCE, 
+                     { PARAM_EARTH_RADIUS, PARAM_ATMOS_RADIUS, 
+                       PARAM_RAYLEIGH, PARAM_MIE, PARAM_MIE_DIR });
+    // Fitted for the current sun, the viewer is followed by the distance
+    m_params.depends(PRODUCT_ANALYTIC_SKY, 
+                     { PARAM_EARTH_RADIUS, PARAM_ATMOS_RADIUS, 
+                       PARAM_RAYLEIGH, PARAM_MIE, PARAM_MIE_DIR, PARAM_SUN });
+    // Per unit intensity, the viewer is followed by its position
+    m_params.depends(PRODUCT_SKY_SH, 
+                     { PARAM_EARTH_RADIUS, PARAM_ATMOS_RADIUS, 
+                       PARAM_RAYLEIGH, PARAM_MIE, PARAM_MIE_DIR, PARAM_SUN });
+    // Per unit intensity, the sun and the viewer are tracked by each tile
+    m_params.depends(PRODUCT_SKY_CUBEMAP, 
+                     { PARAM_EARTH_RADIUS, PARAM_ATMOS_RADIUS, 
+                       PARAM_RAYLEIGH, PARAM_MIE, PARAM_MIE_DIR,
+                       PARAM_SAMPLING });
+}
+
+bool Atmosphere::is_upToDate() const
+{
+    // Same choice of the tables as in draw()
+    if (m_renderMode == RENDER_CPU_REFERENCE)
+        return true;
+
+    bool upToDate = true;
+    if (m_renderMode == RENDER_PRECOMPUTED)
+        upToDate = !m_params.is_stale(PRODUCT_SCATTERING_TABLES);
+    // Ray marching until the first fit, no tables needed after
+    bool analytic = m_renderMode == RENDER_ANALYTIC && is_analyticValid();
+    if (analytic)
+        upToDate = is_analyticUpToDate();
+    if ((m_renderMode != RENDER_PRECOMPUTED && !analytic) || m_renderEarth)
+    {
+        upToDate = upToDate && !m_params.is_stale(PRODUCT_TRANSMITTANCE);
+        if (m_useMultipleScattering || m_renderEarth)
+            upToDate = upToDate && !m_params.is_stale(PRODUCT_MULTIPLE_SCATTERING);
+    }
+    if (m_renderEarth)
+        upToDate = upToDate && !m_params.is_stale(PRODUCT_GROUND_IRRADIANCE);
+    return upToDate;
+}
+
+void Atmosphere::draw(float delta)
+{
+    // Offscreen passes bind it back, the sky may be drawn into a framebuffer
+    GLint target;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+    m_targetFramebuffer = uint32_t(target);
+
+    // 0. Update the sun and rebuild stale precomputed tables
+    if (m_animateSun)
+    {
+        m_sunAngle = glm::mod(m_sunAngle + 0.5f * delta, SUN_ANIMATION_RANGE);
+        sunDir.y = glm::sin(m_sunAngle);
+        sunDir.z = -glm::cos(m_sunAngle);
+        m_params.touch(PARAM_SUN);
+    }
+
+    if (m_params.is_stale(PRODUCT_MODEL_EARTH))
+    {
+        modelEarth();
+        m_params.mark_built(PRODUCT_MODEL_EARTH);
+    }
+
+    // Covers the whole viewport including the planet, needs no tables
+    if (m_renderMode == RENDER_CPU_REFERENCE)
+    {
+        draw_reference();
+        m_meanIterations = -1.f;
+        m_meanLightIterations = -1.f;
+        return;
+    }
+
+    bool aerialPerspective = m_renderEarth && m_aerialPerspective;
+
+    // Tables are built lazily, only for the mode that needs them. Until 
+    //  the first bake finishes, the sky is ray marched instead.
+    RenderMode renderMode = m_renderMode;
+    if (m_renderMode == RENDER_PRECOMPUTED)
+    {
+        update_scatteringTables();
+        if (!m_scatteringTables.is_ready())
+            renderMode = RENDER_RAY_MARCHING;
+    }
+    // The fit is not accurate enough for the limb seen from the altitude
+    if (m_renderMode == RENDER_ANALYTIC)
+    {
+        if (is_analyticValid())
+            update_analyticSky();
+        if (!is_analyticValid() || !m_analyticSky.is_ready())
+            renderMode = RENDER_RAY_MARCHING;
+    }
+    bool analytic = renderMode == RENDER_ANALYTIC;
+    // The dome is centered at the viewer, ray marching takes over from the space
+    if (renderMode == RENDER_DOME && glm::length(m_viewPos) >= R_a)
+        renderMode = RENDER_RAY_MARCHING;
+    bool dome = renderMode == RENDER_DOME;
+
+    // The ground is lit by the sun through the transmittance table
+    if ((renderMode != RENDER_PRECOMPUTED && !analytic) || m_renderEarth)
+    {
+        update_transmittanceLUT();
+        // The ground irradiance is baked from both of the tables
+        if (m_useMultipleScattering || m_renderEarth)
+            update_multipleScatteringLUT();
+    }
+    if (m_renderEarth)
+        update_groundIrradianceLUT();
+    // Valid around the viewer only, the table lights the planet from space
+    //  and until the first projection
+    bool skyAmbientSH = m_renderEarth && m_skyAmbientSH && 
+                        glm::length(m_viewPos) < R_a && update_skySH();
+
+    // The table is parametrized around the viewer, valid only inside
+    //  of the atmosphere, ray marching takes over from the space
+    bool skyView = renderMode == RENDER_SKY_VIEW && glm::length(m_viewPos) < R_a;
+    // The animated sun blends precomputed tables, unless the sequence
+    //  is not ready yet
+    bool skyViewSequence = skyView && m_animateSun && update_skyViewSequence();
+    m_skyViewSequenceDrawn = skyViewSequence;
+    if (skyView && !skyViewSequence)
+        update_skyView();
+
+    if (m_skyCapture)
+        update_skyCubemap();
+
+    // Only the per pixel ray marching is reconstructed over the frames
+    //  or rendered at a lower resolution
+    bool rayMarching = renderMode != RENDER_PRECOMPUTED && !skyView && !analytic && !dome;
+    bool temporal = rayMarching && m_temporalMode != TEMPORAL_OFF;
+    bool compute = rayMarching && m_computeShader && m_computeProgram;
+    bool offscreen = temporal || compute || (rayMarching && m_resolutionDivisor > 1);
+    if (!temporal)
+        m_historyValid = false;
+
+    // 1. draw the Earth (or any like planet)
+    if (m_renderEarth)
+    {
+        if (aerialPerspective)
+            update_aerialPerspective();
+
+        m_drawMeshProgram->use();
+        m_drawMeshProgram->set_mat4("M",  m_modelEarth);
+        //m_drawMeshProgram->set_mat4("MVP",  m_projView * m_modelEarth);
+        m_drawMeshProgram->set_mat4("MVP",  m_proj * m_view * m_modelEarth);
+        m_drawMeshProgram->set_float("toneMappingFactor", m_toneMapping * 1.0);
+
+        // Sun and sky light, flat shaded until both tables are baked
+        m_drawMeshProgram->set_int("useGroundLighting", 
+                                   m_transmittanceLUT.is_ready() &&
+                                   m_groundIrradianceLUT.is_ready());
+        m_drawMeshProgram->set_vec3("sunPos", sunDir);
+        m_drawMeshProgram->set_float("I_sun", I_sun);
+        m_drawMeshProgram->set_float("R_e", R_e);
+        m_drawMeshProgram->set_float("R_a", R_a);
+        m_drawMeshProgram->set_float("groundAlbedo", GROUND_ALBEDO);
+        m_transmittanceTexture->activate(TRANSMITTANCE_UNIT);
+        m_transmittanceTexture->bind();
+        m_drawMeshProgram->set_int("transmittanceLUT", TRANSMITTANCE_UNIT);
+        m_groundIrradianceTexture->activate(GROUND_IRRADIANCE_UNIT);
+        m_groundIrradianceTexture->bind();
+        m_drawMeshProgram->set_int("groundIrradianceLUT", GROUND_IRRADIANCE_UNIT);
+        m_drawMeshProgram->set_int("useSkySH", skyAmbientSH);
+        m_skySHBuffer->bind_base(SKY_SH_BINDING);
+
+        m_drawMeshProgram->set_int("useAerialPerspective", aerialPerspective);
+        if (aerialPerspective)
+        {
+            m_aerialScatteringTexture->activate(AERIAL_SCATTERING_UNIT);
+            m_aerialScatteringTexture->bind();
+            m_drawMeshProgram->set_int("aerialScattering", AERIAL_SCATTERING_UNIT);
+            m_aerialTransmittanceTexture->activate(AERIAL_TRANSMITTANCE_UNIT);
+            m_aerialTransmittanceTexture->bind();
+            m_drawMeshProgram->set_int("aerialTransmittance", 
+                                       AERIAL_TRANSMITTANCE_UNIT);
+
+            m_drawMeshProgram->set_mat4("froxelProjView", m_proj * m_view);
+            m_drawMeshProgram->set_vec3("froxelViewPos", m_viewPos);
+            m_drawMeshProgram->set_vec2("froxelRange", aerialPerspective_range());
+        }
+        m_sphereModel->draw();
+    }
+
+    // 2. Setup properties of the atmosphere
+    if (renderMode == RENDER_PRECOMPUTED)
+    {
+        m_precomputedProgram->use();
+        set_common_uniforms(*m_precomputedProgram);
+
+        m_scatteringTexture->activate(SCATTERING_UNIT);
+        m_scatteringTexture->bind();
+        m_precomputedProgram->set_int("scatteringTexture", SCATTERING_UNIT);
+        m_mieScatteringTexture->activate(MIE_SCATTERING_UNIT);
+        m_mieScatteringTexture->bind();
+        m_precomputedProgram->set_int("mieScatteringTexture", MIE_SCATTERING_UNIT);
+        m_precomputedProgram->set_vec4("scatteringSize", 
+                                       SCATTERING_R_SIZE, SCATTERING_MU_SIZE,
+                                       SCATTERING_MU_S_SIZE, SCATTERING_NU_SIZE);
+    }
+    else if (skyView)
+    {
+        m_drawSkyViewProgram->use();
+        set_common_uniforms(*m_drawSkyViewProgram);
+
+        m_skyViewTexture->activate(SKY_VIEW_UNIT);
+        m_skyViewTexture->bind();
+        m_drawSkyViewProgram->set_int("skyViewLUT", SKY_VIEW_UNIT);
+
+        m_skyViewSequenceTexture->activate(SKY_VIEW_SEQUENCE_UNIT);
+        m_skyViewSequenceTexture->bind();
+        m_drawSkyViewProgram->set_int("skyViewSequence", SKY_VIEW_SEQUENCE_UNIT);
+        m_drawSkyViewProgram->set_int("useSequence", skyViewSequence);
+        if (skyViewSequence)
+        {
+            // Two layers around the current angle, at the centers of their texels
+            float pos = glm::clamp(m_sunAngle / SUN_ANIMATION_RANGE, 0.f, 1.f) *
+                        (SKY_VIEW_SEQUENCE_LAYERS - 1);
+            int layer = glm::min(int(pos), SKY_VIEW_SEQUENCE_LAYERS - 2);
+            m_drawSkyViewProgram->set_vec2("sequenceLayers", 
+                                    (layer + 0.5f) / SKY_VIEW_SEQUENCE_LAYERS,
+                                    (layer + 1.5f) / SKY_VIEW_SEQUENCE_LAYERS);
+            m_drawSkyViewProgram->set_float("sequenceBlend", pos - layer);
+            m_drawSkyViewProgram->set_vec3("sequenceSunDir0", 
+                                           skyViewSequence_sunDir(layer));
+            m_drawSkyViewProgram->set_vec3("sequenceSunDir1", 
+                                           skyViewSequence_sunDir(layer + 1));
+        }
+    }
+    else if (analytic)
+    {
+        m_analyticProgram->use();
+        set_common_uniforms(*m_analyticProgram);
+
+        char name[32];
+        for (int k = 0; k < ANALYTIC_SKY_TERMS; ++k)
+        {
+            snprintf(name, sizeof(name), "coefficients[%d]", k);
+            m_analyticProgram->set_vec3(name, m_analyticSky.front().coefficients()[k]);
+        }
+        m_analyticProgram->set_float("horizonMu", m_analyticSky.front().horizonMu());
+    }
+    else if (dome)
+    {
+        m_domeProgram->use();
+        set_common_uniforms(*m_domeProgram);
+        set_rayMarching_uniforms(*m_domeProgram);
+        m_domeProgram->set_mat4("projView", m_proj * glm::mat4(glm::mat3(m_view)));
+    }
+    else if (!offscreen)
+    {
+        m_atmosphereProgram->use();
+        set_common_uniforms(*m_atmosphereProgram);
+        set_rayMarching_uniforms(*m_atmosphereProgram);
+    }
+
+    // 3. draw the atmosphere, a fullscreen triangle shades each pixel once.
+    //  The sky is behind the planet, or over it when seen from the space.
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_FALSE);
+    if (offscreen)
+    {
+        draw_offscreen(temporal);
+    }
+    else if (dome)
+    {
+        m_domeVao->bind();
+        glDrawElements(GL_TRIANGLES, m_domeIndices, GL_UNSIGNED_INT, nullptr);
+        m_domeVao->unbind();
+    }
+    else
+    {
+        m_fullscreenVao->bind();
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        m_fullscreenVao->unbind();
+    }
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+
+    if (renderMode == RENDER_PRECOMPUTED || skyView || analytic || dome)
+    {
+        m_meanIterations = -1.f;
+        m_meanLightIterations = -1.f;
+    }
+    else if (++m_framesSinceStats >= ITERATION_STATS_INTERVAL)
+        measure_iterations();
+}
+
+void Atmosphere::set_common_uniforms(Shader& program)
+{
+    // View rays of the fullscreen triangle, see draw_atmosphere.vert
+    program.set_mat4("invProj", glm::inverse(m_proj));
+    program.set_mat3("invView", glm::transpose(glm::mat3(m_view)));
+    program.set_float("skyDepth", glm::length(m_viewPos) < R_a ? 1.f : -1.f);
+
+    program.set_vec3("viewPos", m_viewPos);
+    program.set_vec3("sunPos", sunDir);
+
+    program.set_float("I_sun", I_sun);
+    program.set_float("R_e", R_e);
+    program.set_float("R_a", R_a);
+    program.set_float("g", g);
+
+    // GUI stuff
+    program.set_float("toneMappingFactor", m_toneMapping * 1.0);
+}
+
+void Atmosphere::create_dome()
+{
+    std::vector<float> vertices;
+    vertices.reserve((DOME_RINGS + 1) * (DOME_SEGMENTS + 1) * 3);
+    for (int i = 0; i <= DOME_RINGS; ++i)
+    {
+        // Elevation parameter, mapped quadratically around the horizon
+        float v = float(i) / DOME_RINGS * 2.f - 1.f;
+
+        // The seam repeats the first segment, the azimuth stays continuous
+        for (int j = 0; j <= DOME_SEGMENTS; ++j)
+        {
+            float phi = 2.f * float(M_PI) * j / DOME_SEGMENTS;
+            vertices.push_back(std::cos(phi));
+            vertices.push_back(v);
+            vertices.push_back(std::sin(phi));
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(DOME_RINGS * DOME_SEGMENTS * 6);
+    for (int i = 0; i < DOME_RINGS; ++i)
+        for (int j = 0; j < DOME_SEGMENTS; ++j)
+        {
+            uint32_t a = i * (DOME_SEGMENTS + 1) + j;
+            uint32_t b = a + DOME_SEGMENTS + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    m_domeIndices = uint32_t(indices.size());
+
+    m_domeVao = std::make_unique<VertexArray>();
+    auto vbo = std::make_shared<VertexBuffer>(uint32_t(vertices.size() * sizeof(float)),
+                                              vertices.data());
+    vbo->set_layout(BufferLayout({{ElementType::Float3, "position"}}));
+    m_domeVao->add_vertex_buffer(vbo);
+    m_domeVao->set_index_buffer(std::make_shared<IndexBuffer>(m_domeIndices,
+                                                              indices.data()));
+}
+
+void Atmosphere::set_rayMarching_uniforms(Shader& program)
+{
+    program.set_int("viewSamples", viewSamples);
+    program.set_int("lightSamples", lightSamples);
+    program.set_int("adaptiveSampling", m_adaptiveSampling);
+    program.set_float("transmittanceThreshold", m_transmittanceThreshold);
+    program.set_int("skipEmptySpace", m_skipEmptySpace);
+    program.set_vec3("beta_R", beta_R);
+    program.set_float("beta_M", beta_M);
+    program.set_float("H_R", H_R);
+    program.set_float("H_M", H_M);
+
+    m_transmittanceTexture->activate(TRANSMITTANCE_UNIT);
+    m_transmittanceTexture->bind();
+    program.set_int("transmittanceLUT", TRANSMITTANCE_UNIT);
+    // Light rays are marched until the first table is baked
+    bool lut = m_lightIntegrator == LIGHT_TRANSMITTANCE_LUT;
+    program.set_int("lightIntegrator", 
+                    lut && !m_transmittanceLUT.is_ready() ? LIGHT_RAY_MARCHING
+                                                          : m_lightIntegrator);
+
+    m_multipleScatteringTexture->activate(MULTIPLE_SCATTERING_UNIT);
+    m_multipleScatteringTexture->bind();
+    program.set_int("multipleScatteringLUT", MULTIPLE_SCATTERING_UNIT);
+    program.set_int("useMultipleScattering", 
+                    m_useMultipleScattering && m_multipleScatteringLUT.is_ready());
+
+    program.set_int("spectral", m_spectral);
+    if (m_spectral)
+    {
+        float beta[SPECTRAL_BINS];
+        rayleigh_spectrum(beta_R, beta);
+        const auto& toRgb = spectral_to_rgb();
+
+        char name[32];
+        for (int bin = 0; bin < SPECTRAL_BINS; bin += 4)
+        {
+            snprintf(name, sizeof(name), "beta_R_spectral[%d]", bin / 4);
+            program.set_vec4(name, beta[bin], beta[bin + 1], beta[bin + 2], 
+                             beta[bin + 3]);
+        }
+        for (int bin = 0; bin < SPECTRAL_BINS; ++bin)
+        {
+            snprintf(name, sizeof(name), "spectralToRgb[%d]", bin);
+            program.set_vec3(name, toRgb[bin]);
+        }
+    }
+}
+
+void Atmosphere::update_skyView()
+{
+    // Keep the viewport of the window
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    m_skyViewFramebuffer->bind();
+    glViewport(0, 0, SKY_VIEW_WIDTH, SKY_VIEW_HEIGHT);
+    glDisable(GL_DEPTH_TEST);
+
+    m_skyViewProgram->use();
+    set_common_uniforms(*m_skyViewProgram);
+    set_rayMarching_uniforms(*m_skyViewProgram);
+    m_skyViewProgram->set_vec2("skyViewSize", SKY_VIEW_WIDTH, SKY_VIEW_HEIGHT);
+
+    m_fullscreenVao->bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    m_fullscreenVao->unbind();
+
+    glEnable(GL_DEPTH_TEST);
+    m_skyViewFramebuffer->unbind(m_targetFramebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+bool Atmosphere::update_skyViewSequence()
+{
+    // Valid for the altitude of the viewer, the horizontal position
+    //  changes the angles negligibly
+    float r = glm::length(m_viewPos);
+    bool steady = r == m_lastViewRadius;
+    m_lastViewRadius = r;
+
+    if (!m_params.is_stale(PRODUCT_SKY_VIEW_SEQUENCE) && sunDir.x == m_sequenceSunX &&
+        glm::abs(r - m_sequenceRadius) < SKY_VIEW_SEQUENCE_TOLERANCE)
+        return true;
+
+    // A moving viewer would rebake every frame, a stale table bakes
+    //  the sequence wrong, the table of each frame is used meanwhile
+    bool tablesReady = !m_params.is_stale(PRODUCT_TRANSMITTANCE) &&
+                       (!m_useMultipleScattering || 
+                        !m_params.is_stale(PRODUCT_MULTIPLE_SCATTERING));
+    if (!steady || !tablesReady)
+        return false;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glViewport(0, 0, SKY_VIEW_WIDTH, SKY_VIEW_HEIGHT);
+    glDisable(GL_DEPTH_TEST);
+
+    m_skyViewProgram->use();
+    set_common_uniforms(*m_skyViewProgram);
+    set_rayMarching_uniforms(*m_skyViewProgram);
+    m_skyViewProgram->set_vec2("skyViewSize", SKY_VIEW_WIDTH, SKY_VIEW_HEIGHT);
+    // Radiance is linear in the intensity, applied when the sequence is read
+    m_skyViewProgram->set_float("I_sun", 1.f);
+
+    m_sequenceSunX = sunDir.x;
+    m_fullscreenVao->bind();
+    for (int layer = 0; layer < SKY_VIEW_SEQUENCE_LAYERS; ++layer)
+    {
+        m_skyViewSequenceFramebuffer->attach_color_layer(*m_skyViewSequenceTexture,
+                                                         layer, 0);
+        m_skyViewSequenceFramebuffer->bind();
+        m_skyViewProgram->set_vec3("sunPos", skyViewSequence_sunDir(layer));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    m_fullscreenVao->unbind();
+
+    glEnable(GL_DEPTH_TEST);
+    m_skyViewSequenceFramebuffer->unbind(m_targetFramebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    m_sequenceRadius = r;
+    m_params.mark_built(PRODUCT_SKY_VIEW_SEQUENCE, 
+                        m_params.stamp(PRODUCT_SKY_VIEW_SEQUENCE));
+    LOG_INFO("Sky-view sequence of " << SKY_VIEW_SEQUENCE_LAYERS 
+             << " sun angles baked");
+    return true;
+}
+
+glm::vec3 Atmosphere::skyViewSequence_sunDir(int layer) const
+{
+    // Same path as the animated sun in draw()
+    float angle = SUN_ANIMATION_RANGE * layer / (SKY_VIEW_SEQUENCE_LAYERS - 1);
+    return glm::vec3(m_sequenceSunX, glm::sin(angle), -glm::cos(angle));
+}
+
+void Atmosphere::draw_offscreen(bool temporal)
+{
+    // Keep the state of the window
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    // Rounded up, the image stretches slightly over the viewport
+    glm::ivec2 viewportSize(viewport[2], viewport[3]);
+    glm::ivec2 size = (viewportSize + m_resolutionDivisor - 1) / m_resolutionDivisor;
+
+    glDisable(GL_DEPTH_TEST);
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+
+    const Texture2D* image;
+    if (temporal)
+    {
+        render_temporal(size);
+        image = m_historyTextures[m_historyIndex].get();
+    }
+    else
+    {
+        render_sky(size, m_computeShader && m_computeProgram);
+        image = m_skyTexture.get();
+    }
+
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    glEnable(GL_DEPTH_TEST);
+
+    // Upsampled over the viewport, hidden by the planet as the direct path
+    m_drawOffscreenProgram->use();
+    set_common_uniforms(*m_drawOffscreenProgram);
+    m_drawOffscreenProgram->set_vec2("viewportSize", glm::vec2(viewportSize));
+    image->activate(SKY_IMAGE_UNIT);
+    image->bind();
+    m_drawOffscreenProgram->set_int("skyImage", SKY_IMAGE_UNIT);
+
+    m_fullscreenVao->bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    m_fullscreenVao->unbind();
+}
+
+void Atmosphere::render_sky(const glm::ivec2& size, bool compute)
+{
+    if (size != m_skySize)
+    {
+        m_skyTexture->upload((const float*)nullptr, size.x, size.y);
+        m_skySize = size;
+    }
+
+    if (compute)
+    {
+        m_computeProgram->use();
+        set_common_uniforms(*m_computeProgram);
+        set_rayMarching_uniforms(*m_computeProgram);
+        m_computeProgram->set_int("groundHidden", 
+                                  m_renderEarth && glm::length(m_viewPos) < R_a);
+        m_skyTexture->bind_image(SKY_IMAGE_BINDING, GL_WRITE_ONLY);
+
+        glDispatchCompute((size.x + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE,
+                          (size.y + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE, 1);
+        // Sampled by the upsampling right after
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        return;
+    }
+
+    m_skyFramebuffer->bind();
+    glViewport(0, 0, size.x, size.y);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    m_atmosphereProgram->use();
+    set_common_uniforms(*m_atmosphereProgram);
+    set_rayMarching_uniforms(*m_atmosphereProgram);
+    m_atmosphereProgram->set_int("outputRadiance", 1);
+
+    m_fullscreenVao->bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    m_fullscreenVao->unbind();
+
+    m_atmosphereProgram->set_int("outputRadiance", 0);
+
+    m_skyFramebuffer->unbind(m_targetFramebuffer);
+}
+
+void Atmosphere::render_temporal(const glm::ivec2& size)
+{
+    glm::ivec2 latticeSize = (size + 1) / 2;
+    int lattices = m_temporalMode == TEMPORAL_HALF ? 2 : 1;
+
+    if (size != m_historySize)
+    {
+        m_latticeTexture->upload((const float*)nullptr, latticeSize.x, 
+                                 2 * latticeSize.y);
+        for (auto& texture : m_historyTextures)
+            texture->upload((const float*)nullptr, size.x, size.y);
+        m_historySize = size;
+        m_historyValid = false;
+    }
+
+    // The history would lag behind a changed atmosphere or a jumping sun
+    glm::vec3 sun = glm::normalize(sunDir);
+    if (m_params.is_stale(PRODUCT_TEMPORAL_HISTORY) || I_sun != m_prevSunIntensity ||
+        glm::dot(sun, m_prevSunDir) < glm::cos(TEMPORAL_SUN_TOLERANCE))
+        m_historyValid = false;
+    m_params.mark_built(PRODUCT_TEMPORAL_HISTORY, 
+                        m_params.stamp(PRODUCT_TEMPORAL_HISTORY));
+
+    // 1. Ray march the lattices of this frame, radiance without tone mapping
+    m_latticeFramebuffer->bind();
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    m_atmosphereProgram->use();
+    set_common_uniforms(*m_atmosphereProgram);
+    set_rayMarching_uniforms(*m_atmosphereProgram);
+    m_atmosphereProgram->set_int("outputRadiance", 1);
+
+    glm::ivec2 offsets[2];
+    for (int k = 0; k < lattices; ++k)
+    {
+        offsets[k] = temporalLattices[(m_temporalFrame * lattices + k) % 4];
+        glViewport(0, k * latticeSize.y, latticeSize.x, latticeSize.y);
+
+        // Moves the center of each lattice pixel to the center of its pixel
+        //  in the full image
+        glm::mat4 jitter(1.f);
+        jitter[0][0] = float(size.x) / (2 * latticeSize.x);
+        jitter[1][1] = float(size.y) / (2 * latticeSize.y);
+        jitter[3][0] = float(size.x - 2 * offsets[k].x + 1) / (2 * latticeSize.x) - 1.f;
+        jitter[3][1] = float(size.y - 2 * offsets[k].y + 1) / (2 * latticeSize.y) - 1.f;
+        m_atmosphereProgram->set_mat4("invProj", glm::inverse(jitter * m_proj));
+
+        m_fullscreenVao->bind();
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        m_fullscreenVao->unbind();
+    }
+    m_atmosphereProgram->set_int("outputRadiance", 0);
+    m_atmosphereProgram->set_mat4("invProj", glm::inverse(m_proj));
+
+    // 2. Reconstruct the full image
+    int current = 1 - m_historyIndex;
+    m_historyFramebuffers[current]->bind();
+    glViewport(0, 0, size.x, size.y);
+
+    m_resolveTemporalProgram->use();
+    m_resolveTemporalProgram->set_vec3("viewPos", m_viewPos);
+    m_resolveTemporalProgram->set_float("R_a", R_a);
+    m_resolveTemporalProgram->set_mat4("invProj", glm::inverse(m_proj));
+    m_resolveTemporalProgram->set_mat3("invView", 
+                                       glm::transpose(glm::mat3(m_view)));
+    m_resolveTemporalProgram->set_mat4("prevProjView", m_prevProjView);
+
+    m_latticeTexture->activate(LATTICE_UNIT);
+    m_latticeTexture->bind();
+    m_resolveTemporalProgram->set_int("lattices", LATTICE_UNIT);
+    m_resolveTemporalProgram->set_ivec2("latticeSize", latticeSize);
+    m_resolveTemporalProgram->set_int("latticeCount", lattices);
+    m_resolveTemporalProgram->set_ivec2("latticeOffset[0]", offsets[0]);
+    m_resolveTemporalProgram->set_ivec2("latticeOffset[1]", offsets[lattices - 1]);
+
+    m_historyTextures[m_historyIndex]->activate(HISTORY_UNIT);
+    m_historyTextures[m_historyIndex]->bind();
+    m_resolveTemporalProgram->set_int("history", HISTORY_UNIT);
+    m_resolveTemporalProgram->set_int("historyValid", m_historyValid);
+
+    m_fullscreenVao->bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    m_fullscreenVao->unbind();
+
+    m_historyFramebuffers[current]->unbind(m_targetFramebuffer);
+
+    m_historyIndex = current;
+    m_historyValid = true;
+    m_prevProjView = m_proj * m_view;
+    m_prevSunDir = sun;
+    m_prevSunIntensity = I_sun;
+    ++m_temporalFrame;
+}
+
+void Atmosphere::draw_reference()
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    m_referenceRenderer.render(get_params(), get_referenceView(), 
+                               viewport[2], viewport[3]);
+
+    const LUT2D& image = m_referenceRenderer.image();
+    m_referenceTexture->upload(image.ptr(), image.width, image.height);
+    m_referenceTexture->set_clamp_to_edge();
+    m_referenceTexture->set_filtering(GL_NEAREST, GL_NEAREST);
+
+    glDisable(GL_DEPTH_TEST);
+
+    m_drawReferenceProgram->use();
+    m_drawReferenceProgram->set_float("toneMappingFactor", m_toneMapping * 1.0);
+    m_referenceTexture->activate(REFERENCE_UNIT);
+    m_referenceTexture->bind();
+    m_drawReferenceProgram->set_int("referenceImage", REFERENCE_UNIT);
+
+    m_fullscreenVao->bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    m_fullscreenVao->unbind();
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+void Atmosphere::update_aerialPerspective()
+{
+    // Keep the viewport of the window
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glViewport(0, 0, AERIAL_PERSPECTIVE_SIZE, AERIAL_PERSPECTIVE_SIZE);
+    glDisable(GL_DEPTH_TEST);
+
+    m_aerialProgram->use();
+    set_common_uniforms(*m_aerialProgram);
+    set_rayMarching_uniforms(*m_aerialProgram);
+    m_aerialProgram->set_mat4("invProjView", glm::inverse(m_proj * m_view));
+    m_aerialProgram->set_float("froxelSize", AERIAL_PERSPECTIVE_SIZE);
+    m_aerialProgram->set_vec2("froxelRange", aerialPerspective_range());
+
+    // One fullscreen pass per slice, rendering into both volumes at once
+    m_fullscreenVao->bind();
+    for (int slice = 0; slice < AERIAL_PERSPECTIVE_SIZE; ++slice)
+    {
+        m_aerialFramebuffer->attach_color_layer(*m_aerialScatteringTexture, 
+                                                slice, 0);
+        m_aerialFramebuffer->attach_color_layer(*m_aerialTransmittanceTexture,
+                                                slice, 1);
+        m_aerialFramebuffer->bind();
+        m_aerialProgram->set_float("slice", slice);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    m_fullscreenVao->unbind();
+
+    glEnable(GL_DEPTH_TEST);
+    m_aerialFramebuffer->unbind(m_targetFramebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+glm::vec2 Atmosphere::aerialPerspective_range() const
+{
+    float r = glm::length(m_viewPos);
+    float nearDist = glm::max(r - R_a, 0.f);
+    float farDist = glm::sqrt(glm::max(r * r - R_e * R_e, 0.f)) +
+                    glm::sqrt(R_a * R_a - R_e * R_e);
+
+    return glm::vec2(nearDist, glm::max(farDist, nearDist + 1.f));
+}
+
+void Atmosphere::measure_iterations()
+{
+    m_framesSinceStats = 0;
+
+    // Keep the state of the window
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    m_iterationsFramebuffer->bind();
+    glViewport(0, 0, ITERATION_STATS_WIDTH, ITERATION_STATS_HEIGHT);
+
+    // Pixels without the atmosphere stay negative
+    glClearColor(-1.f, -1.f, -1.f, -1.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // The program may be left with other uniforms, e.g. of a cube map face,
+    //  or not drawn at all by the compute path
+    m_atmosphereProgram->use();
+    set_common_uniforms(*m_atmosphereProgram);
+    set_rayMarching_uniforms(*m_atmosphereProgram);
+    m_atmosphereProgram->set_int("outputIterations", 1);
+    m_fullscreenVao->bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    m_fullscreenVao->unbind();
+    m_atmosphereProgram->set_int("outputIterations", 0);
+
+    // View iterations in red, light iterations in green
+    std::vector<glm::vec2> iterations(ITERATION_STATS_WIDTH * 
+                                      ITERATION_STATS_HEIGHT);
+    glReadPixels(0, 0, ITERATION_STATS_WIDTH, ITERATION_STATS_HEIGHT, 
+                 GL_RG, GL_FLOAT, iterations.data());
+
+    glm::dvec2 sum(0.0);
+    int count = 0;
+    for (const glm::vec2& i : iterations)
+    {
+        if (i.x < 0.f)
+            continue;
+        sum += glm::dvec2(i);
+        ++count;
+    }
+    m_meanIterations = count > 0 ? float(sum.x / count) : 0.f;
+    m_meanLightIterations = count > 0 ? float(sum.y / count) : 0.f;
+
+    m_iterationsFramebuffer->unbind(m_targetFramebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+bool Atmosphere::update_skySH()
+{
+    ParamTracker::Stamp stamp;
+    if (m_skySH.swap_if_ready(stamp))
+    {
+        // std140 pads each vec3 of an array to vec4
+        glm::vec4 block[SKY_SH_COEFFICIENTS];
+        for (int k = 0; k < SKY_SH_COEFFICIENTS; ++k)
+            block[k] = glm::vec4(m_skySH.front().coefficients()[k], 0.f);
+        m_skySHBuffer->set_data(sizeof(block), block);
+
+        m_params.mark_built(PRODUCT_SKY_SH, stamp);
+    }
+
+    // Multiple scattering of the same params, as the ground irradiance,
+    //  the animated sun keeps a projection running with the latest sun
+    if (!m_skySH.is_building() && !is_skySHUpToDate() &&
+        !m_params.is_stale(PRODUCT_MULTIPLE_SCATTERING))
+    {
+        AtmosphereParams params = get_params();
+        glm::vec3 viewPos = m_viewPos;
+        glm::vec3 sun = glm::normalize(sunDir);
+        auto multipleScattering = std::make_shared<const MultipleScatteringLUT>(
+                                      m_multipleScatteringLUT.front());
+        m_skySH.start(m_params.stamp(PRODUCT_SKY_SH),
+                      [params, viewPos, sun, multipleScattering](SkySH& sh) {
+            sh.project(params, viewPos, sun, *multipleScattering);
+        });
+    }
+
+    return m_skySH.is_ready();
+}
+
+bool Atmosphere::is_skySHUpToDate() const
+{
+    return m_skySH.is_ready() && !m_params.is_stale(PRODUCT_SKY_SH) &&
+           m_skySH.front().viewPos() == m_viewPos;
+}
+
+bool Atmosphere::is_analyticValid() const
+{
+    return glm::length(m_viewPos) - R_e < ANALYTIC_SKY_MAX_ALTITUDE * (R_a - R_e);
+}
+
+bool Atmosphere::is_analyticUpToDate() const
+{
+    return m_analyticSky.is_ready() && !m_params.is_stale(PRODUCT_ANALYTIC_SKY) &&
+           glm::length(m_viewPos - m_analyticSky.front().viewPos()) <= 
+               ANALYTIC_SKY_REFIT_DISTANCE;
+}
+
+void Atmosphere::update_analyticSky()
+{
+    ParamTracker::Stamp stamp;
+    if (m_analyticSky.swap_if_ready(stamp))
+        m_params.mark_built(PRODUCT_ANALYTIC_SKY, stamp);
+
+    // The animated sun keeps a fit running, each one with the latest sun
+    if (!m_analyticSky.is_building() && !is_analyticUpToDate())
+    {
+        AtmosphereParams params = get_params();
+        glm::vec3 viewPos = m_viewPos;
+        glm::vec3 sun = sunDir;
+        m_analyticSky.start(m_params.stamp(PRODUCT_ANALYTIC_SKY),
+                            [params, viewPos, sun](AnalyticSky& sky) {
+            sky.fit(params, viewPos, sun);
+        });
+    }
+}
+
+void Atmosphere::update_skyCubemap()
+{
+    const ParamTracker::Stamp stamp = m_params.stamp(PRODUCT_SKY_CUBEMAP);
+    const glm::vec3 sun = glm::normalize(sunDir);
+    const float viewRadius = glm::length(m_viewPos);
+    const float tileNdc = 2.f / SKY_CUBEMAP_TILES;
+
+    // Tile outdated the most, the sun moving over it counts more than
+    //  behind it, since the sky around the sun changes the fastest
+    int best = 0;
+    float bestPriority = -1.f;
+    bool allCurrent = true;
+    for (int i = 0; i < int(m_skyCubemapTiles.size()); ++i)
+    {
+        SkyCubemapTile& tile = m_skyCubemapTiles[i];
+        ++tile.age;
+
+        float priority = float(tile.age);
+        if (tile.stamp != stamp)
+        {
+            priority += 1e6f;
+            allCurrent = false;
+        }
+        else
+        {
+            int face = i / (SKY_CUBEMAP_TILES * SKY_CUBEMAP_TILES);
+            int t = i % (SKY_CUBEMAP_TILES * SKY_CUBEMAP_TILES);
+            glm::vec3 center(((t % SKY_CUBEMAP_TILES) + 0.5f) * tileNdc - 1.f,
+                             ((t / SKY_CUBEMAP_TILES) + 0.5f) * tileNdc - 1.f, -1.f);
+            center = glm::normalize(glm::transpose(glm::mat3(cubemap_faceView(face))) *
+                                    center);
+
+            float sunMoved = glm::acos(glm::clamp(glm::dot(sun, tile.sunDir), 
+                                                  -1.f, 1.f));
+            priority += SKY_CUBEMAP_SUN_PRIORITY * sunMoved * 
+                        (1.f + glm::max(glm::dot(center, sun), 0.f));
+            priority += SKY_CUBEMAP_ALTITUDE_PRIORITY * 
+                        glm::abs(viewRadius - tile.viewRadius);
+        }
+
+        if (priority > bestPriority)
+        {
+            best = i;
+            bestPriority = priority;
+        }
+    }
+    if (allCurrent)
+        m_params.mark_built(PRODUCT_SKY_CUBEMAP, stamp);
+
+    // Keep the viewport of the window
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    int face = best / (SKY_CUBEMAP_TILES * SKY_CUBEMAP_TILES);
+    int t = best % (SKY_CUBEMAP_TILES * SKY_CUBEMAP_TILES);
+    const int tileSize = SKY_CUBEMAP_SIZE / SKY_CUBEMAP_TILES;
+
+    // The whole face is projected, only the tile is shaded
+    m_skyCubemapFramebuffer->attach_color_face(*m_skyCubemap, face);
+    m_skyCubemapFramebuffer->bind();
+    glViewport(0, 0, SKY_CUBEMAP_SIZE, SKY_CUBEMAP_SIZE);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor((t % SKY_CUBEMAP_TILES) * tileSize, (t / SKY_CUBEMAP_TILES) * tileSize,
+              tileSize, tileSize);
+    glDisable(GL_DEPTH_TEST);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    m_atmosphereProgram->use();
+    set_common_uniforms(*m_atmosphereProgram);
+    set_rayMarching_uniforms(*m_atmosphereProgram);
+    m_atmosphereProgram->set_mat4("invProj", glm::inverse(
+                                  glm::perspective(glm::radians(90.f), 1.f, 0.1f, 10.f)));
+    m_atmosphereProgram->set_mat3("invView", 
+                                  glm::transpose(glm::mat3(cubemap_faceView(face))));
+    m_atmosphereProgram->set_float("I_sun", 1.f);
+    m_atmosphereProgram->set_int("outputRadiance", 1);
+
+    m_fullscreenVao->bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    m_fullscreenVao->unbind();
+
+    m_atmosphereProgram->set_int("outputRadiance", 0);
+
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    m_skyCubemapFramebuffer->unbind(m_targetFramebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    SkyCubemapTile& tile = m_skyCubemapTiles[best];
+    tile.stamp = stamp;
+    tile.sunDir = sun;
+    tile.viewRadius = viewRadius;
+    tile.age = 0;
+}
+
+void Atmosphere::update_transmittanceLUT()
+{
+    // Finished bake, swap in the new table
+    ParamTracker::Stamp stamp;
+    if (m_transmittanceLUT.swap_if_ready(stamp))
+    {
+        const LUT2D& table = m_transmittanceLUT.front().table();
+        m_transmittanceTexture->upload(table.ptr(), table.width, table.height);
+        m_transmittanceTexture->set_clamp_to_edge();
+        m_transmittanceTexture->set_linear_filtering();
+
+        m_params.mark_built(PRODUCT_TRANSMITTANCE, stamp);
+    }
+
+    // Only one bake at a time, changes made meanwhile start the next one
+    if (m_params.is_stale(PRODUCT_TRANSMITTANCE))
+    {
+        AtmosphereParams params = get_params();
+        m_transmittanceLUT.start(m_params.stamp(PRODUCT_TRANSMITTANCE),
+                                 [params](TransmittanceLUT& lut) {
+            lut.bake(params);
+        });
+    }
+}
+
+void Atmosphere::update_multipleScatteringLUT()
+{
+    ParamTracker::Stamp stamp;
+    if (m_multipleScatteringLUT.swap_if_ready(stamp))
+    {
+        const LUT2D& table = m_multipleScatteringLUT.front().table();
+        m_multipleScatteringTexture->upload(table.ptr(), table.width, table.height);
+        m_multipleScatteringTexture->set_clamp_to_edge();
+        m_multipleScatteringTexture->set_linear_filtering();
+
+        m_params.mark_built(PRODUCT_MULTIPLE_SCATTERING, stamp);
+    }
+
+    if (m_params.is_stale(PRODUCT_MULTIPLE_SCATTERING))
+    {
+        AtmosphereParams params = get_params();
+        m_multipleScatteringLUT.start(m_params.stamp(PRODUCT_MULTIPLE_SCATTERING),
+                                      [params](MultipleScatteringLUT& lut) {
+            lut.bake(params);
+        });
+    }
+}
+
+void Atmosphere::update_groundIrradianceLUT()
+{
+    ParamTracker::Stamp stamp;
+    if (m_groundIrradianceLUT.swap_if_ready(stamp))
+    {
+        const LUT2D& table = m_groundIrradianceLUT.front().table();
+        m_groundIrradianceTexture->upload(table.ptr(), table.width, table.height);
+        m_groundIrradianceTexture->set_clamp_to_edge();
+        m_groundIrradianceTexture->set_linear_filtering();
+
+        m_params.mark_built(PRODUCT_GROUND_IRRADIANCE, stamp);
+    }
+
+    // Baked from the finished tables of the current params, copied as the
+    //  front tables are swapped by their next bakes
+    if (m_params.is_stale(PRODUCT_GROUND_IRRADIANCE) && 
+        !m_groundIrradianceLUT.is_building() &&
+        !m_params.is_stale(PRODUCT_TRANSMITTANCE) &&
+        !m_params.is_stale(PRODUCT_MULTIPLE_SCATTERING))
+    {
+        AtmosphereParams params = get_params();
+        auto transmittance = std::make_shared<const TransmittanceLUT>(
+                                 m_transmittanceLUT.front());
+        auto multipleScattering = std::make_shared<const MultipleScatteringLUT>(
+                                      m_multipleScatteringLUT.front());
+        m_groundIrradianceLUT.start(m_params.stamp(PRODUCT_GROUND_IRRADIANCE),
+                                    [params, transmittance, multipleScattering]
+                                    (GroundIrradianceLUT& lut) {
+            lut.bake(params, *transmittance, *multipleScattering);
+        });
+    }
+}
+
+void Atmosphere::update_scatteringTables()
+{
+    ParamTracker::Stamp stamp;
+    if (m_scatteringTables.swap_if_ready(stamp))
+    {
+        const ScatteringTables& tables = m_scatteringTables.front();
+        const LUT4D& scattering = tables.scattering();
+        m_scatteringTexture->upload(scattering.ptr(), scattering.width(),
+                                    scattering.height(), scattering.depth());
+        const LUT4D& mie = tables.mieScattering();
+        m_mieScatteringTexture->upload(mie.ptr(), mie.width(), mie.height(),
+                                       mie.depth());
+
+        // Logged here, the log is not synchronized with the workers
+        LOG_INFO("Precomputed " << tables.orders() << " scattering orders in "
+                 << tables.bake_seconds() << " s");
+
+        m_params.mark_built(PRODUCT_SCATTERING_TABLES, stamp);
+    }
+
+    if (m_params.is_stale(PRODUCT_SCATTERING_TABLES))
+    {
+        AtmosphereParams params = get_params();
+        int orders = m_scatteringOrders;
+        m_scatteringTables.start(m_params.stamp(PRODUCT_SCATTERING_TABLES),
+                                 [params, orders](ScatteringTables& tables) {
+            tables.bake(params, orders);
+        });
+    }
+}
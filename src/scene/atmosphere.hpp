@@ -9,7 +9,22 @@
 #pragma once
 
 #include "opengl/shader.hpp"
+#include "opengl/texture2d.hpp"
+#include "opengl/texture3d.hpp"
+#include "opengl/texture_cube.hpp"
+#include "opengl/framebuffer.hpp"
+#include "opengl/buffer.hpp"
+#include "opengl/vertex_array.hpp"
 #include "scene/mesh.hpp"
+#include "cpu/transmittance_lut.hpp"
+#include "cpu/scattering_tables.hpp"
+#include "cpu/multiple_scattering_lut.hpp"
+#include "cpu/ground_irradiance_lut.hpp"
+#include "cpu/sky_sh.hpp"
+#include "cpu/analytic_sky.hpp"
+#include "cpu/async_table.hpp"
+#include "cpu/reference_renderer.hpp"
+#include "core/dependency_tracker.hpp"
 
 #include <memory>
 
@@ -21,16 +36,71 @@
 class Atmosphere
 {
 public:
-    Atmosphere(const std::shared_ptr<Shader>& drawMeshProgram, 
-               Mesh* sphereModel)   // TODO Dangerous
-        : m_drawMeshProgram(drawMeshProgram),
-          m_sphereModel(sphereModel)
-    { 
-        set_defaults();
+    /** @brief How the colors of the sky are computed */
+    enum RenderMode
+    {
+        RENDER_RAY_MARCHING,    ///< Integrates single scattering per pixel
+        RENDER_PRECOMPUTED,     ///< Looks up precomputed multiple scattering
+        RENDER_SKY_VIEW,        ///< Ray marches a low resolution table 
+                                ///  around the viewer each frame
+        RENDER_ANALYTIC,        ///< Closed-form model fitted on the CPU,
+                                ///  see AnalyticSky
+        RENDER_DOME,            ///< Integrates per vertex of a dome around
+                                ///  the viewer, the Mie phase per pixel
+        RENDER_CPU_REFERENCE    ///< Ray marches each pixel on the CPU,
+                                ///  see ReferenceRenderer
+    };
+
+    /** @brief How transmittance along the light rays is computed */
+    enum LightIntegrator
+    {
+        LIGHT_RAY_MARCHING,         ///< Samples each light ray
+        LIGHT_TRANSMITTANCE_LUT,    ///< Looks up a precomputed table
+        LIGHT_CHAPMAN               ///< Closed form of the optical depth
+    };
 
-        m_atmosphereProgram = std::make_unique<Shader>("shaders/draw_atmosphere.vert",
-                                                       "shaders/draw_atmosphere.frag");
-    }
+    /** @brief Pixels of the ray marched sky shaded each frame */
+    enum TemporalMode
+    {
+        TEMPORAL_OFF,           ///< All the pixels
+        TEMPORAL_HALF,          ///< Checkerboard, the rest is reprojected
+        TEMPORAL_QUARTER        ///< One pixel of each 2x2 block
+    };
+
+    /** @brief Groups of parameters changed together by the setters */
+    enum Param
+    {
+        PARAM_SUN,              ///< Direction and intensity of the sun
+        PARAM_EARTH_RADIUS,
+        PARAM_ATMOS_RADIUS,
+        PARAM_RAYLEIGH,         ///< Rayleigh coefficient and scale height
+        PARAM_MIE,              ///< Mie coefficient and scale height
+        PARAM_MIE_DIR,          ///< Anisotropy of Mie scattering
+        PARAM_SCATTERING_ORDERS,
+        PARAM_SAMPLING,         ///< Sampling and integrators of the ray marching
+        PARAM_COUNT
+    };
+
+    /** @brief Data derived from the parameters, rebuilt only when stale */
+    enum Product
+    {
+        PRODUCT_MODEL_EARTH,            ///< Model matrix of the planet
+        PRODUCT_TRANSMITTANCE,          ///< Transmittance table
+        PRODUCT_MULTIPLE_SCATTERING,    ///< Multiple scattering approximation
+        PRODUCT_SCATTERING_TABLES,      ///< Bruneton tables
+        PRODUCT_SKY_VIEW_SEQUENCE,      ///< Sky-view tables over the sun animation
+        PRODUCT_TEMPORAL_HISTORY,       ///< Reconstructed sky of the last frame
+        PRODUCT_GROUND_IRRADIANCE,      ///< Sky irradiance of the ground
+        PRODUCT_SKY_CUBEMAP,            ///< Capture of the sky, stamped per tile
+        PRODUCT_SKY_SH,                 ///< Ambient light around the viewer
+        PRODUCT_ANALYTIC_SKY,           ///< Coefficients of the analytic model
+        PRODUCT_COUNT
+    };
+
+    using ParamTracker = DependencyTracker<PARAM_COUNT, PRODUCT_COUNT>;
+
+    Atmosphere(const std::shared_ptr<Shader>& drawMeshProgram, 
+               Mesh* sphereModel);   // TODO Dangerous
 
     // @brief Sets defaut to Earth-like atmosphere
     void set_defaults()
@@ -48,6 +118,7 @@ public:
         H_R = e_H_R;
         H_M = e_H_M;
         g = e_g;
+        m_params.touch_all();
     }
     void set_sunDefaults()
     {
@@ -55,12 +126,14 @@ public:
         sunDir = defSunDir;
         set_sunAngle(defSunAngle);
         I_sun = e_I_sun;
+        m_params.touch(PARAM_SUN);
     }
 
     void set_rayleighDefaults()
     {
         beta_R = e_beta_R;
         H_R = e_H_R;
+        m_params.touch(PARAM_RAYLEIGH);
     }
 
     void set_mieDefaults()
@@ -68,6 +141,8 @@ public:
         beta_M = e_beta_M;
         H_M = e_H_M;
         g = e_g;
+        m_params.touch(PARAM_MIE);
+        m_params.touch(PARAM_MIE_DIR);
     }
 
     void set_sizeDefaults()
@@ -77,50 +152,7 @@ public:
         m_renderEarth = false;
     }
 
-    void draw(float delta)
-    {
-        // 1. draw the Earth (or any like planet)
-        if (m_renderEarth)
-        {
-            m_drawMeshProgram->use();
-            //m_drawMeshProgram->set_mat4("MVP",  m_projView * m_modelEarth);
-            m_drawMeshProgram->set_mat4("MVP",  m_proj * m_view * m_modelEarth);
-            m_sphereModel->draw();
-        }
-
-        // 2. Setup properties of the atmosphere
-        m_atmosphereProgram->use();
-        m_atmosphereProgram->set_mat4("M", m_modelAtmos);
-        //m_atmosphereProgram->set_mat4("MVP", m_projView * m_modelAtmos);
-        m_atmosphereProgram->set_mat4("MVP", m_proj * m_view * m_modelAtmos);
-
-        m_atmosphereProgram->set_vec3("viewPos", m_viewPos);
-        m_atmosphereProgram->set_int("viewSamples", viewSamples);
-        m_atmosphereProgram->set_int("lightSamples", lightSamples);
-
-        m_atmosphereProgram->set_float("I_sun", I_sun);
-        m_atmosphereProgram->set_float("R_e", R_e);
-        m_atmosphereProgram->set_float("R_a", R_a);
-        m_atmosphereProgram->set_vec3("beta_R", beta_R);
-        m_atmosphereProgram->set_float("beta_M", beta_M);
-        m_atmosphereProgram->set_float("H_R", H_R);
-        m_atmosphereProgram->set_float("H_M", H_M);
-        m_atmosphereProgram->set_float("g", g);
-
-        // 3. Handle GUI stuff
-        m_atmosphereProgram->set_float("toneMappingFactor", m_toneMapping * 1.0);
-        if (m_animateSun)
-        {
-            m_sunAngle = glm::mod(m_sunAngle + 0.5 * delta, M_PI + glm::radians(20.f));
-            sunDir.y = glm::sin(m_sunAngle);
-            sunDir.z = -glm::cos(m_sunAngle);
-        }
-
-        m_atmosphereProgram->set_vec3("sunPos", sunDir);
-
-        // 4. draw the atmosphere
-        m_sphereModel->draw();
-    }
+    void draw(float delta);
 
     // ----------------------------------------------------------------------------
     // Getters
@@ -128,9 +160,46 @@ public:
     const glm::vec3& get_viewPos() { return m_viewPos; }
     int get_viewSamples() { return viewSamples; }
     int get_lightSamples() { return lightSamples; }
+    bool is_adaptiveSampling() { return m_adaptiveSampling; }
+    float get_transmittanceThreshold() { return m_transmittanceThreshold; }
+    bool is_skipEmptySpace() { return m_skipEmptySpace; }
+    /** @return Mean iterations of the view loop per pixel, measured every 
+     *          few frames, negative when the mode does not ray march */
+    float get_meanIterations() { return m_meanIterations; }
+    /** @return Mean samples of the light rays per pixel, one per lookup of
+     *          the LUT or the closed form, negative like the view ones */
+    float get_meanLightIterations() { return m_meanLightIterations; }
 
     bool is_toneMapping() { return m_toneMapping; }
+    LightIntegrator get_lightIntegrator() { return m_lightIntegrator; }
+    bool is_aerialPerspective() { return m_aerialPerspective; }
+    bool is_skyAmbientSH() { return m_skyAmbientSH; }
+    bool is_multipleScattering() { return m_useMultipleScattering; }
+    bool is_spectral() { return m_spectral; }
+    RenderMode get_renderMode() { return m_renderMode; }
+    TemporalMode get_temporalMode() { return m_temporalMode; }
+    int get_resolutionDivisor() { return m_resolutionDivisor; }
+    bool is_computeShader() { return m_computeShader; }
+    /** @return Whether the context supports the compute shader path */
+    bool is_computeSupported() { return m_computeProgram != nullptr; }
+    bool is_skyCapture() { return m_skyCapture; }
+    /** 
+     * @return Radiance of the sky around the viewer per unit intensity of 
+     *  the sun, without tone mapping, for reflections and backgrounds. 
+     *  Updated by tiles while the sky capture is enabled.
+     */
+    const TextureCube& get_skyCubemap() const { return *m_skyCubemap; }
+    int get_scatteringOrders() { return m_scatteringOrders; }
+    /** @return Tables of the RENDER_PRECOMPUTED mode, complete once 
+     *          is_upToDate() in the mode */
+    const ScatteringTables& get_scatteringTables() const 
+    { 
+        return m_scatteringTables.front(); 
+    }
     bool is_animateSun() { return m_animateSun; }
+    /** @return Whether the last frame blended the sky-view sequence, its 
+     *          cost does not depend on the samples */
+    bool is_skyViewSequenceDrawn() { return m_skyViewSequenceDrawn; }
     float get_sunAngle() { return m_sunAngle; }
 
     float get_earthRadius() { return R_e; }
@@ -146,8 +215,42 @@ public:
     float get_mieScaleHeight() { return H_M; }
     float get_mieScatteringDir() { return g; }
 
+    /** @return Current properties of the atmosphere for the CPU side model */
+    AtmosphereParams get_params() const
+    {
+        return { I_sun, R_e, R_a, beta_R, H_R, beta_M, H_M, g };
+    }
+
+    /** @return Properties of the atmosphere set by set_defaults() */
+    static AtmosphereParams get_defaultParams()
+    {
+        return { e_I_sun, e_R_e, e_R_a, e_beta_R, e_H_R, e_beta_M, e_H_M, e_g };
+    }
+    static int get_defaultViewSamples() { return defViewSamples; }
+    static int get_defaultLightSamples() { return defLightSamples; }
+
+    /** @return Current camera and sampling for the CPU reference renderer */
+    ReferenceView get_referenceView() const
+    {
+        return { m_viewPos, m_proj, m_view, sunDir, viewSamples, lightSamples,
+                 m_spectral };
+    }
+
+    /** @return Duration of the last CPU reference render in seconds */
+    double get_referenceTime() const { return m_referenceRenderer.render_time(); }
+
     bool is_renderEarth() { return m_renderEarth; }
 
+    /** @return Versions of the parameters and staleness of derived data */
+    const ParamTracker& get_paramTracker() const { return m_params; }
+
+    /** 
+     * @return Whether the tables read by the current render mode are built
+     *  for the current parameters, the asynchronous bakes lag behind the
+     *  setters by a few frames
+     */
+    bool is_upToDate() const;
+
     // ----------------------------------------------------------------------------
     // Setters
     // ----------------------------------------------------------------------------
@@ -163,10 +266,61 @@ public:
         m_viewPos = cameraPos;
     }
 
-    void set_viewSamples(int samples) { viewSamples = samples; }
-    void set_lightSamples(int samples) { lightSamples = samples; }
+    void set_viewSamples(int samples)
+    {
+        viewSamples = samples;
+        m_params.touch(PARAM_SAMPLING);
+    }
+    void set_lightSamples(int samples)
+    {
+        lightSamples = samples;
+        m_params.touch(PARAM_SAMPLING);
+    }
+    void set_adaptiveSampling(bool b)
+    {
+        m_adaptiveSampling = b;
+        m_params.touch(PARAM_SAMPLING);
+    }
+    void set_transmittanceThreshold(float t)
+    {
+        m_transmittanceThreshold = t;
+        m_params.touch(PARAM_SAMPLING);
+    }
+    void set_skipEmptySpace(bool b)
+    {
+        m_skipEmptySpace = b;
+        m_params.touch(PARAM_SAMPLING);
+    }
 
     void set_toneMapping(bool b) { m_toneMapping = b; }
+    void set_lightIntegrator(LightIntegrator i)
+    {
+        m_lightIntegrator = i;
+        m_params.touch(PARAM_SAMPLING);
+    }
+    void set_aerialPerspective(bool b) { m_aerialPerspective = b; }
+    void set_skyAmbientSH(bool b) { m_skyAmbientSH = b; }
+    void set_spectral(bool b)
+    {
+        m_spectral = b;
+        m_params.touch(PARAM_SAMPLING);
+    }
+    void set_multipleScattering(bool b)
+    {
+        m_useMultipleScattering = b;
+        m_params.touch(PARAM_SAMPLING);
+    }
+    void set_renderMode(RenderMode mode) { m_renderMode = mode; }
+    void set_temporalMode(TemporalMode mode) { m_temporalMode = mode; }
+    // @param divisor of the viewport size, 1, 2 or 4
+    void set_resolutionDivisor(int divisor) { m_resolutionDivisor = divisor; }
+    void set_computeShader(bool b) { m_computeShader = b; }
+    void set_skyCapture(bool b) { m_skyCapture = b; }
+    void set_scatteringOrders(int orders)
+    {
+        m_scatteringOrders = orders;
+        m_params.touch(PARAM_SCATTERING_ORDERS);
+    }
     void set_animateSun(bool b) { m_animateSun = b; }
     // @param angle in radians
     void set_sunAngle(float angle) {
@@ -174,29 +328,58 @@ public:
         m_sunAngle = angle;
         sunDir.y = glm::sin(m_sunAngle);
         sunDir.z = -glm::cos(m_sunAngle);
+        m_params.touch(PARAM_SUN);
     }
 
-    void set_sunDir(const glm::vec3 dir) { sunDir = dir; }
-    void set_sunIntensity(float I) { I_sun = I; }
+    void set_sunDir(const glm::vec3 dir) 
+    { 
+        sunDir = dir; 
+        m_params.touch(PARAM_SUN);
+    }
+    void set_sunIntensity(float I) 
+    { 
+        I_sun = I; 
+        m_params.touch(PARAM_SUN);
+    }
 
     void set_earthRadius(float R)
     {
         R_e = R;
-        modelEarth();
+        m_params.touch(PARAM_EARTH_RADIUS);
     }
     
     void set_atmosRadius(float R)
     {
         R_a = R;
-        modelAtmos();
+        m_params.touch(PARAM_ATMOS_RADIUS);
     }
 
-    void set_rayleighScattering(const glm::vec3 beta_s) { beta_R = beta_s; }
-    void set_rayleighScaleHeight(float H) { H_R = H; }
+    void set_rayleighScattering(const glm::vec3 beta_s) 
+    { 
+        beta_R = beta_s;
+        m_params.touch(PARAM_RAYLEIGH);
+    }
+    void set_rayleighScaleHeight(float H) 
+    { 
+        H_R = H; 
+        m_params.touch(PARAM_RAYLEIGH);
+    }
 
-    void set_mieScattering(float beta_s) { beta_M = beta_s; }
-    void set_mieScaleHeight(float H) { H_M = H; }
-    void set_mieScatteringDir(float d) { g = d; }
+    void set_mieScattering(float beta_s) 
+    { 
+        beta_M = beta_s; 
+        m_params.touch(PARAM_MIE);
+    }
+    void set_mieScaleHeight(float H) 
+    { 
+        H_M = H; 
+        m_params.touch(PARAM_MIE);
+    }
+    void set_mieScatteringDir(float d) 
+    { 
+        g = d; 
+        m_params.touch(PARAM_MIE_DIR);
+    }
 
     void set_renderEarth(bool b) { m_renderEarth = b; }
 
@@ -205,25 +388,340 @@ private:
     // Rendering 
 
     std::unique_ptr<Shader> m_atmosphereProgram; 
+    std::unique_ptr<Shader> m_precomputedProgram;
+    std::unique_ptr<Shader> m_skyViewProgram;         ///< Fills the sky-view table
+    std::unique_ptr<Shader> m_drawSkyViewProgram;     ///< Reads the sky-view table
+    std::unique_ptr<Shader> m_analyticProgram;        ///< Closed-form sky
+    std::unique_ptr<Shader> m_domeProgram;            ///< Ray marches per vertex
+    std::unique_ptr<Shader> m_drawReferenceProgram;   ///< Shows the CPU render
+    std::unique_ptr<Shader> m_aerialProgram;          ///< Fills the froxel volume
     std::shared_ptr<Shader> m_drawMeshProgram;
     const Mesh* m_sphereModel;
 
-    glm::mat4 m_modelAtmos;    ///< Model matrix for the atmossphere
     glm::mat4 m_modelEarth;    ///< Model matrix for the planet
     //glm::mat4 m_projView;      ///< Camera's projection view matrix
     glm::mat4 m_proj;
     glm::mat4 m_view;
+    uint32_t m_targetFramebuffer = 0;  ///< Bound when draw() was called
 
-    void modelAtmos() {
-        m_modelAtmos = glm::scale(glm::mat4(1.0f), glm::vec3(R_a, R_a, R_a));
-    }
     void modelEarth() {
         m_modelEarth = glm::scale(glm::mat4(1.0f), glm::vec3(R_e, R_e, R_e));
     }
 
+    ParamTracker m_params;  ///< Versions of the parameters, see Param
+
+    /** @brief Declares which parameters each product is derived from */
+    void init_dependencies();
+
+    // ----------------------------------------------------------------------------
+    // Precomputed tables
+
+    // All the tables are built on the worker threads, the last finished
+    //  table stays in use until the next one is swapped in. Changes made
+    //  during a bake are coalesced into the following one.
+
+    AsyncTable<TransmittanceLUT> m_transmittanceLUT;
+    std::unique_ptr<Texture2D> m_transmittanceTexture;
+    LightIntegrator m_lightIntegrator = LIGHT_TRANSMITTANCE_LUT;
+
+    AsyncTable<MultipleScatteringLUT> m_multipleScatteringLUT;
+    std::unique_ptr<Texture2D> m_multipleScatteringTexture;
+    bool m_useMultipleScattering = true;
+
+    AsyncTable<GroundIrradianceLUT> m_groundIrradianceLUT;
+    std::unique_ptr<Texture2D> m_groundIrradianceTexture;
+
+    // Sky irradiance around the viewer replacing the table near the viewer
+    AsyncTable<SkySH> m_skySH;
+    std::unique_ptr<UniformBuffer> m_skySHBuffer;   ///< std140 vec4 per coefficient
+    bool m_skyAmbientSH = false;
+
+    // Fitted to the sky around the viewer, refitted as the viewer moves
+    AsyncTable<AnalyticSky> m_analyticSky;
+
+    AsyncTable<ScatteringTables> m_scatteringTables;
+    std::unique_ptr<Texture3D> m_scatteringTexture;
+    std::unique_ptr<Texture3D> m_mieScatteringTexture;
+    int m_scatteringOrders = DEFAULT_SCATTERING_ORDERS;
+
+    std::unique_ptr<Texture2D> m_skyViewTexture;
+    std::unique_ptr<Framebuffer> m_skyViewFramebuffer;
+    std::unique_ptr<VertexArray> m_fullscreenVao;   ///< Empty, for a fullscreen pass
+    std::unique_ptr<VertexArray> m_domeVao;         ///< See create_dome
+    uint32_t m_domeIndices = 0;
+
+    // Sky-view tables of SKY_VIEW_SEQUENCE_LAYERS sun angles over the range
+    //  of the animation, baked once for the altitude of the viewer and
+    //  blended during the playback instead of ray marching each frame
+    std::unique_ptr<Texture3D> m_skyViewSequenceTexture;
+    std::unique_ptr<Framebuffer> m_skyViewSequenceFramebuffer;
+    float m_sequenceRadius = -1.f;  ///< Distance of the viewer from the center
+    float m_sequenceSunX = 0.f;     ///< Component of the sun out of the animation plane
+    float m_lastViewRadius = -1.f;  ///< Distance of the viewer in the last frame
+
+    // Ray marched sky rendered offscreen at the viewport size divided by
+    //  m_resolutionDivisor, upsampled over the viewport along the edges
+    //  of the planet
+    int m_resolutionDivisor = 1;
+    std::unique_ptr<Shader> m_drawOffscreenProgram; ///< Upsamples and composites
+    std::unique_ptr<Texture2D> m_skyTexture;        ///< Radiance, alpha marks the atmosphere
+    std::unique_ptr<Framebuffer> m_skyFramebuffer;
+    glm::ivec2 m_skySize = glm::ivec2(0);
+
+    // Compute shader filling the sky image by tiles, skips the tiles
+    //  without the atmosphere or with the ground hidden by the planet.
+    //  Created only in OpenGL 4.3 and higher.
+    std::unique_ptr<Shader> m_computeProgram;
+    bool m_computeShader = false;
+
+    // Temporal reconstruction of the ray marched sky. Each frame shades
+    //  lattices of one pixel per 2x2 block into a compact target, the other
+    //  pixels are reprojected from the last frame or filled from the lattices.
+    TemporalMode m_temporalMode = TEMPORAL_OFF;
+    std::unique_ptr<Shader> m_resolveTemporalProgram;   ///< Reconstructs the frame
+    std::unique_ptr<Texture2D> m_latticeTexture;    ///< Lattices stacked vertically
+    std::unique_ptr<Framebuffer> m_latticeFramebuffer;
+    std::unique_ptr<Texture2D> m_historyTextures[2];    ///< Reconstructed radiance
+    std::unique_ptr<Framebuffer> m_historyFramebuffers[2];
+    int m_historyIndex = 0;         ///< History reconstructed in the last frame
+    bool m_historyValid = false;    ///< Whether the last frame can be reprojected
+    glm::ivec2 m_historySize = glm::ivec2(0);
+    int m_temporalFrame = 0;        ///< Selects the lattices shaded in a frame
+    glm::mat4 m_prevProjView = glm::mat4(1.f);  ///< View-projection of the last frame
+    glm::vec3 m_prevSunDir = glm::vec3(0.f);    ///< Sun of the last frame
+    float m_prevSunIntensity = 0.f;
+
+    // Froxel volume over the camera frustum with in-scattering and
+    //  transmittance towards the viewer, applied to the scene geometry
+    std::unique_ptr<Texture3D> m_aerialScatteringTexture;
+    std::unique_ptr<Texture3D> m_aerialTransmittanceTexture;
+    std::unique_ptr<Framebuffer> m_aerialFramebuffer;
+    bool m_aerialPerspective = true;
+
+    // Sky around the viewer in a cube map, a single tile of a face is ray
+    //  marched per frame, the most outdated one
+    struct SkyCubemapTile
+    {
+        ParamTracker::Stamp stamp = 0;  ///< Of PRODUCT_SKY_CUBEMAP, 0 when empty
+        glm::vec3 sunDir = glm::vec3(0.f);
+        float viewRadius = 0.f;         ///< Distance of the viewer from the center
+        int age = 0;                    ///< Frames since the last update
+    };
+    std::unique_ptr<TextureCube> m_skyCubemap;
+    std::unique_ptr<Framebuffer> m_skyCubemapFramebuffer;
+    std::vector<SkyCubemapTile> m_skyCubemapTiles;
+    bool m_skyCapture = false;
+
+    // Ground truth rendered on the CPU in the RENDER_CPU_REFERENCE mode
+    ReferenceRenderer m_referenceRenderer;
+    std::unique_ptr<Texture2D> m_referenceTexture;
+
+    RenderMode m_renderMode = RENDER_RAY_MARCHING;
+
+    /// Ray marched sky integrates SPECTRAL_BINS wavelengths instead of RGB
+    bool m_spectral = false;
+
+    /** 
+     * @brief Uploads a finished transmittance table and starts a new bake 
+     *  on the worker threads when the table is stale 
+     */
+    void update_transmittanceLUT();
+
+    /** 
+     * @brief Uploads a finished multiple scattering table and starts 
+     *  a new bake on the worker threads when the table is stale 
+     */
+    void update_multipleScatteringLUT();
+
+    /** 
+     * @brief Uploads a finished ground irradiance table and starts 
+     *  a new bake on the worker threads when the table is stale 
+     */
+    void update_groundIrradianceLUT();
+
+    /** 
+     * @brief Uploads the coefficients of a finished projection, projects
+     *  the sky around the viewer again when the atmosphere or the sun 
+     *  changed, or the viewer moved
+     * @return Whether any projection is finished, the first one waits for
+     *  the multiple scattering table
+     */
+    bool update_skySH();
+
+    /** @return Whether the projection in use is of the current params and viewer */
+    bool is_skySHUpToDate() const;
+
+    /** @return Whether the analytic model is valid at the altitude of the viewer */
+    bool is_analyticValid() const;
+
+    /** 
+     * @brief Fits the analytic model again when the atmosphere or the sun
+     *  changed, or the viewer moved
+     */
+    void update_analyticSky();
+
+    /** @return Whether the fit in use is of the current params and viewer */
+    bool is_analyticUpToDate() const;
+
+    /** 
+     * @brief Ray marches the most outdated tile of the sky cube map, the
+     *  tiles with outdated parameters first, the tiles facing the sun when
+     *  it moves, the oldest tile otherwise
+     */
+    void update_skyCubemap();
+
+    /** 
+     * @brief Uploads finished scattering tables and starts a new bake 
+     *  on the worker threads when the tables are stale 
+     */
+    void update_scatteringTables();
+
+    /** @brief Ray marches the sky around the viewer into the sky-view table */
+    void update_skyView();
+
+    /**
+     * @brief Rebuilds the sequence of sky-view tables over the sun animation
+     *  when stale. The bake is deferred while the viewer changes altitude
+     *  or the tables it ray marches with are being rebuilt.
+     * @return Whether the sequence is valid for the current frame
+     */
+    bool update_skyViewSequence();
+
+    /** @return Direction of the sun in a layer of the sky-view sequence */
+    glm::vec3 skyViewSequence_sunDir(int layer) const;
+
+    /**
+     * @brief Ray marches the sky into an offscreen image, reconstructed over
+     *  the frames or at a lower resolution, and draws it over the viewport
+     * @param temporal Whether the temporal reconstruction is used
+     */
+    void draw_offscreen(bool temporal);
+
+    /** 
+     * @brief Ray marches all the pixels of an image of the given size
+     * @param compute Whether the compute shader fills the image instead
+     *                of the fragment shader
+     */
+    void render_sky(const glm::ivec2& size, bool compute);
+
+    /**
+     * @brief Ray marches a part of the pixels of an image of the given size,
+     *  reconstructs the rest from the last frame into the next history
+     */
+    void render_temporal(const glm::ivec2& size);
+
+    /** @brief Renders the sky on the CPU and draws it over the viewport */
+    void draw_reference();
+
+    /** @brief Ray marches the froxel volume of the current camera frustum */
+    void update_aerialPerspective();
+
+    /** 
+     * @brief Distance of the first and the last slice of the froxel volume,
+     *  covers the atmosphere visible from the viewer up to the horizon 
+     */
+    glm::vec2 aerialPerspective_range() const;
+
+    /** 
+     * @brief Draws the atmosphere once more with the active ray marching 
+     *  program and the camera into a small buffer with the view and light
+     *  iteration counts and averages them.
+     *  Stalls the pipeline, meant to be called once in a while.
+     */
+    void measure_iterations();
+
+    /** @brief Sets uniforms shared by all the programs drawing the sky */
+    void set_common_uniforms(Shader& program);
+
+    /**
+     * @brief Creates the dome of the RENDER_DOME mode, a grid of azimuths
+     *  and elevation parameters mapped to the directions around the viewer
+     *  in draw_atmosphere_dome.vert, with the rings denser at the horizon
+     */
+    void create_dome();
+
+    /** @brief Sets uniforms of the programs ray marching the atmosphere */
+    void set_rayMarching_uniforms(Shader& program);
+
+    inline static const int TRANSMITTANCE_UNIT = 0;
+    inline static const int SCATTERING_UNIT = 1;
+    inline static const int MIE_SCATTERING_UNIT = 2;
+    inline static const int SKY_VIEW_UNIT = 3;
+    inline static const int AERIAL_SCATTERING_UNIT = 4;
+    inline static const int AERIAL_TRANSMITTANCE_UNIT = 5;
+    inline static const int MULTIPLE_SCATTERING_UNIT = 6;
+    inline static const int REFERENCE_UNIT = 7;
+    inline static const int SKY_VIEW_SEQUENCE_UNIT = 8;
+    inline static const int LATTICE_UNIT = 9;
+    inline static const int HISTORY_UNIT = 10;
+    inline static const int SKY_IMAGE_UNIT = 11;
+    inline static const int GROUND_IRRADIANCE_UNIT = 12;
+    inline static const int SKY_IMAGE_BINDING = 0;  ///< Image unit of compute_sky
+    inline static const int SKY_SH_BINDING = 0;     ///< Uniform block SkySH
+
+    // Pixels along each side of a work group of compute_sky
+    inline static const int COMPUTE_TILE_SIZE = 8;
+
+    // Latitude x longitude resolution of the sky-view table
+    inline static const int SKY_VIEW_WIDTH = 192;
+    inline static const int SKY_VIEW_HEIGHT = 108;
+
+    // Sun angles in the sky-view sequence, about 3 degrees apart, and change
+    //  of the altitude of the viewer [km] which invalidates the sequence
+    inline static const int SKY_VIEW_SEQUENCE_LAYERS = 64;
+    inline static const float SKY_VIEW_SEQUENCE_TOLERANCE = 0.01f;
+
+    // Distance of the viewer from the last fit of the analytic sky [km]
+    //  which starts the next one
+    inline static const float ANALYTIC_SKY_REFIT_DISTANCE = 0.01f;
+
+    // Sun movement between frames [rad] above which the history is dropped,
+    //  about a degree, slower changes are bounded by the shaded neighbours
+    inline static const float TEMPORAL_SUN_TOLERANCE = 0.0175f;
+
+    // Sun angles covered by the animation, from the sunrise to 20 degrees
+    //  below the opposite horizon
+    inline static const float SUN_ANIMATION_RANGE = float(M_PI * 10.0 / 9.0);
+
+    // Resolution of the iteration statistics and frames between measurements
+    inline static const int ITERATION_STATS_WIDTH = 64;
+    inline static const int ITERATION_STATS_HEIGHT = 36;
+    inline static const int ITERATION_STATS_INTERVAL = 30;
+
+    // Size of each face of the sky cube map and tiles along each side
+    //  of a face, all the tiles are updated in 6 * SKY_CUBEMAP_TILES^2 frames
+    inline static const int SKY_CUBEMAP_SIZE = 128;
+    inline static const int SKY_CUBEMAP_TILES = 2;
+    // Frames of age equivalent to a radian of the sun movement, i.e. a tile
+    //  facing the sun is outdated by about 0.5 degree as much as the whole
+    //  round, and to a kilometre of the altitude of the viewer
+    inline static const float SKY_CUBEMAP_SUN_PRIORITY = 1400.f;
+    inline static const float SKY_CUBEMAP_ALTITUDE_PRIORITY = 240.f;
+
+    // Rings from the nadir to the zenith and segments of each ring of the 
+    //  dome, 4753 vertices ray marched each frame regardless of the resolution
+    inline static const int DOME_RINGS = 48;
+    inline static const int DOME_SEGMENTS = 96;
+
+    // Resolution of the froxel volume along each axis
+    inline static const int AERIAL_PERSPECTIVE_SIZE = 32;
+
     glm::vec3 m_viewPos;    ///< Position of the viewer, camera
     int viewSamples;        ///< Number of samples along the view (primary) ray
     int lightSamples;       ///< Number of samples along the light (secondary) ray
+    bool m_adaptiveSampling = false;    ///< Whether view samples follow the density
+    float m_transmittanceThreshold = 1e-3f; ///< View ray ends below, 0 disables
+    bool m_skipEmptySpace = true;       ///< Whether samples in the shadow of
+                                        ///  the planet get no sunlight, else
+                                        ///  the light ray passes the planet
+
+    // Iterations of the view and light loops, rendered at low resolution 
+    //  and read back
+    std::unique_ptr<Texture2D> m_iterationsTexture;
+    std::unique_ptr<Framebuffer> m_iterationsFramebuffer;
+    float m_meanIterations = -1.f;
+    float m_meanLightIterations = -1.f;
+    int m_framesSinceStats = 0;
 
     // ----------------------------------------------------------------------------
     // GUI stuff
@@ -231,6 +729,7 @@ private:
 
     bool m_animateSun = false;
     float m_sunAngle;
+    bool m_skyViewSequenceDrawn = false;
 
     bool m_renderEarth = false;
 
@@ -0,0 +1,44 @@
+/**
+ * Aerial perspective from the froxel volume filled by 
+ * compute_aerial_perspective.frag, for any shader drawing scene geometry.
+ * Slices are distributed quadratically in the distance from the viewer,
+ * denser close to it.
+ */
+
+uniform sampler3D aerialScattering;     // In-scattering towards the viewer
+uniform sampler3D aerialTransmittance;  // Transmittance towards the viewer
+uniform bool useAerialPerspective;      // Whether the volume is valid
+
+uniform mat4 froxelProjView;    // Projection view matrix of the volume
+uniform vec3 froxelViewPos;     // Position of the viewer of the volume
+uniform vec2 froxelRange;       // Distance of the first and the last slice
+
+/**
+ * @brief Attenuates the color of a surface and adds in-scattered light 
+ *  between the surface and the viewer
+ * @param color Color of the surface
+ * @param worldPos Position of the surface
+ */
+vec3 applyAerialPerspective(vec3 color, vec3 worldPos)
+{
+    if (!useAerialPerspective)
+        return color;
+
+    vec4 clip = froxelProjView * vec4(worldPos, 1.0);
+    vec2 uv = clip.xy / clip.w * 0.5 + 0.5;
+
+    float d = length(worldPos - froxelViewPos);
+    float w = sqrt(clamp((d - froxelRange.x) / (froxelRange.y - froxelRange.x),
+                         0.0, 1.0));
+
+    vec3 inScattering = texture(aerialScattering, vec3(uv, w)).rgb;
+    vec3 transmittance = texture(aerialTransmittance, vec3(uv, w)).rgb;
+
+    // In front of the first slice center fade towards no atmosphere
+    float slices = float(textureSize(aerialScattering, 0).z);
+    float fade = clamp(w * slices * 2.0, 0.0, 1.0);
+    inScattering *= fade;
+    transmittance = mix(vec3(1.0), transmittance, fade);
+
+    return color * transmittance + inScattering;
+}
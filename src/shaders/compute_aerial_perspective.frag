@@ -0,0 +1,31 @@
+#version 450 core
+
+in vec2 fsTexCoord;
+
+layout(location = 0) out vec4 inScattering;
+layout(location = 1) out vec4 transmittance;
+
+uniform vec3 viewPos;       // Position of the viewer
+uniform mat4 invProjView;   // Inverse projection view matrix of the camera
+
+uniform float froxelSize;   // Number of froxels along each axis
+uniform float slice;        // Index of the slice being rendered
+uniform vec2 froxelRange;   // Distance of the first and the last slice
+
+#include "ray_marching.glsl"
+
+void main()
+{
+    // View ray through the center of the froxel column
+    vec2 ndc = gl_FragCoord.xy / froxelSize * 2.0 - 1.0;
+    vec4 farPoint = invProjView * vec4(ndc, 1.0, 1.0);
+    vec3 ray = normalize(farPoint.xyz / farPoint.w - viewPos);
+
+    // Quadratic distribution of the slices, see aerial_perspective.glsl
+    float w = (slice + 0.5) / froxelSize;
+    float d = froxelRange.x + (froxelRange.y - froxelRange.x) * w * w;
+
+    vec3 T;
+    inScattering = vec4(integrateScattering(ray, viewPos, d, T), 1.0);
+    transmittance = vec4(T, 1.0);
+}
@@ -0,0 +1,25 @@
+#version 450 core
+
+in vec2 fsTexCoord;
+
+out vec4 finalColor;
+
+uniform vec3 viewPos;       // Position of the viewer
+uniform vec2 skyViewSize;   // Size of the sky-view table
+
+#include "ray_marching.glsl"
+#include "sky_view.glsl"
+
+void main()
+{
+    // Texel centers map to the ends of the parameter range
+    vec2 uv = (gl_FragCoord.xy - 0.5) / (skyViewSize - 1.0);
+
+    vec3 up, forward, side;
+    skyViewFrame(viewPos, normalize(sunPos), up, forward, side);
+
+    vec3 ray = skyViewUvToDirection(uv, length(viewPos), up, forward, side);
+
+    // Radiance without tone mapping, applied when the table is read
+    finalColor = vec4(computeSkyColor(ray, viewPos), 1.0);
+}
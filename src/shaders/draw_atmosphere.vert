@@ -1,29 +1,23 @@
 #version 450 core
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec2 texCoord;
+out vec3 fsRay;         // Direction of the view ray, not normalized
 
-out vec3 fsPosition;
-//out vec3 fsNormal;
-//out vec2 fsTexCoord;
-
-uniform mat4 M;     // Model matrix
-uniform mat4 MVP;   // Model - View - Projection matrix
+uniform mat4 invProj;   // Inverse projection
+uniform mat3 invView;   // Rotation from the view space to the world
+uniform float skyDepth; // Depth of the sky in NDC, the far plane from inside
+                        //  of the atmosphere, the near plane from outside
 
 void main()
 {
-    vec4 posVec4 = vec4(position, 1.0);
-    fsPosition = vec3(M * posVec4);
-	gl_Position = MVP * posVec4;
+    // Single triangle covering the whole viewport, generated from the
+    //  vertex index, expects an empty vertex array to be bound
+    vec2 ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
 
-    // <UNUSED>
-    // TODO precompute normal matrix
-    //mat3 N = transpose(inverse(mat3(M)));
-    //fsNormal = normalize(N * normal);
-    //fsNormal = normalize(vec4(M * vec4(position, 0.0)).xyz);
+    // Towards the near plane in the view space, affine in the screen space
+    //  so the interpolation is exact, and well conditioned for distant 
+    //  far planes unlike the far plane in the world space
+    vec4 nearPoint = invProj * vec4(ndc, -1.0, 1.0);
+    fsRay = invView * (nearPoint.xyz / nearPoint.w);
 
-    // <UNUSED>
-    //fsTexCoord = texCoord;
+    gl_Position = vec4(ndc, skyDepth, 1.0);
 }
-
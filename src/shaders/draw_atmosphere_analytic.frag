@@ -0,0 +1,56 @@
+#version 450 core
+
+out vec4 finalColor;
+
+uniform vec3 viewPos;   // Position of the viewer
+uniform vec3 sunPos;    // Position of the sun, light direction
+
+uniform float R_a;      // Radius of the atmosphere [m]
+uniform float I_sun;    // Intensity of the sun
+uniform float g;        // Mie scattering direction
+
+uniform float toneMappingFactor;    ///< Whether tone mapping is applied
+
+// Fitted on the CPU per unit intensity, see AnalyticSky
+uniform vec3 coefficients[20];  // Horizon terms times sun terms, row major
+uniform float horizonMu;        // Cosine of the zenith angle of the horizon
+
+#include "view_ray.glsl"
+
+/**
+ * @brief Radiance of the sky per unit intensity of the sun in closed form,
+ *  the terms of AnalyticSky::terms
+ * @param ray Normalized direction of the view ray
+ */
+vec3 analyticSky(vec3 ray)
+{
+    float mu = max(dot(ray, normalize(viewPos)) - horizonMu, 0.0);
+    float nu = dot(ray, normalize(sunPos));
+
+    float x = 1.0 + g * g - 2.0 * g * nu;
+    vec4 p = vec4(1.0, nu, nu * nu, (1.0 + nu * nu) / (x * sqrt(x)));
+
+    return mat4x3(coefficients[0], coefficients[1],
+                  coefficients[2], coefficients[3]) * p
+         + mat4x3(coefficients[4], coefficients[5],
+                  coefficients[6], coefficients[7]) * p * exp(-2.0 * mu)
+         + mat4x3(coefficients[8], coefficients[9],
+                  coefficients[10], coefficients[11]) * p * exp(-8.0 * mu)
+         + mat4x3(coefficients[12], coefficients[13],
+                  coefficients[14], coefficients[15]) * p * exp(-30.0 * mu)
+         + mat4x3(coefficients[16], coefficients[17],
+                  coefficients[18], coefficients[19]) * p * exp(-120.0 * mu);
+}
+
+void main()
+{
+    vec3 ray = atmosphereRay(viewPos, R_a);
+
+    // Fitted radiance may undershoot slightly in the dark parts
+    vec3 acolor = max(analyticSky(ray), vec3(0.0)) * I_sun;
+
+    // Apply tone mapping
+    acolor = mix(acolor, (1.0 - exp(-1.0 * acolor)), toneMappingFactor);
+
+    finalColor = vec4(acolor, 1.0);
+}
@@ -0,0 +1,35 @@
+#version 450 core
+
+#define M_PI 3.1415926535897932384626433832795
+
+in vec3 fsRay;          // Direction of the view ray, not normalized
+in vec3 fsScattering;   // Rayleigh and multiple scattering, phase applied
+in vec3 fsMie;          // Mie scattering without the phase function
+
+out vec4 finalColor;
+
+uniform vec3 sunPos;    // Position of the sun, light direction
+uniform float g;        // Mie scattering direction
+
+uniform float toneMappingFactor;    ///< Whether tone mapping is applied
+
+void main()
+{
+    // Interpolated across the flat triangle, exact after the normalization
+    vec3 ray = normalize(fsRay);
+
+    // Only the sharp Mie Phase function is evaluated per pixel
+    float mu = dot(ray, normalize(sunPos));
+    float mu_2 = mu * mu;
+    float g_2 = g * g;
+    float phase_M = 3.0 / (8.0 * M_PI) * 
+                          ((1.0 - g_2) * (1.0 + mu_2)) / 
+                          ((2.0 + g_2) * pow(1.0 + g_2 - 2.0 * g * mu, 1.5));
+
+    vec3 acolor = fsScattering + fsMie * phase_M;
+
+    // Apply tone mapping
+    acolor = mix(acolor, (1.0 - exp(-1.0 * acolor)), toneMappingFactor);
+
+    finalColor = vec4(acolor, 1.0);
+}
@@ -0,0 +1,42 @@
+#version 450 core
+
+// Azimuth on the unit circle in xz, elevation parameter in [-1, 1] in y,
+//  see Atmosphere::create_dome
+layout(location = 0) in vec3 position;
+
+out vec3 fsRay;         // Direction of the view ray, not normalized
+out vec3 fsScattering;  // Rayleigh and multiple scattering, phase applied
+out vec3 fsMie;         // Mie scattering without the phase function
+
+uniform mat4 projView;  // Rotation to the view space and projection
+uniform vec3 viewPos;   // Position of the viewer
+
+#include "ray_marching.glsl"
+
+void main()
+{
+    // Frame of the horizon of the viewer
+    vec3 up = normalize(viewPos);
+    vec3 tangent = normalize(cross(up, abs(up.x) < 0.9 ? vec3(1.0, 0.0, 0.0)
+                                                        : vec3(0.0, 0.0, 1.0)));
+    vec3 bitangent = cross(tangent, up);
+
+    // Rings are quadratically denser towards the horizon, which dips below
+    //  the zenith angle of 90 degrees with the altitude
+    float r = length(viewPos);
+    float horizon = -acos(clamp(R_e / r, 0.0, 1.0));
+    float v = position.y;
+    float elevation = v >= 0.0 ? horizon + (0.5 * M_PI - horizon) * v * v
+                               : horizon - (0.5 * M_PI + horizon) * v * v;
+
+    vec3 ray = cos(elevation) * (position.x * tangent + position.z * bitangent) +
+               sin(elevation) * up;
+
+    vec3 transmittance;
+    fsScattering = integrateScatteringSplit(ray, viewPos, 1e9, fsMie, transmittance);
+    fsRay = ray;
+
+    // At the far plane, behind the planet
+    vec4 clip = projView * vec4(ray, 0.0);
+    gl_Position = clip.xyww;
+}
@@ -0,0 +1,119 @@
+#version 450 core
+
+// Relative difference of the ray lengths through the atmosphere at which
+//  the weight of a sample drops to 1/e
+#define DEPTH_SIGMA 0.1
+
+out vec4 finalColor;
+
+uniform vec3 viewPos;   // Position of the viewer
+
+uniform float R_e;      // Radius of the planet
+uniform float R_a;      // Radius of the atmosphere
+
+uniform float toneMappingFactor;    ///< Whether tone mapping is applied
+
+uniform mat4 invProj;       // Inverse projection
+uniform mat3 invView;       // Rotation from the view space to the world
+uniform vec2 viewportSize;  // Size of the window
+
+uniform sampler2D skyImage; // Radiance of the sky, alpha marks the atmosphere,
+                            //  the same size as the window or smaller
+
+#include "view_ray.glsl"
+
+/**
+ * @brief View ray through a point of the screen, the near plane in the view
+ *  space is well conditioned for distant far planes
+ */
+vec3 viewRay(vec2 ndc)
+{
+    vec4 nearPoint = invProj * vec4(ndc, -1.0, 1.0);
+    return normalize(invView * (nearPoint.xyz / nearPoint.w));
+}
+
+/**
+ * @brief Length of a ray through the atmosphere, negative when it ends 
+ *  on the ground, which separates the planet from the sky
+ */
+float rayDepth(vec3 dir)
+{
+    float b = dot(dir, viewPos);
+    float r2 = dot(viewPos, viewPos);
+
+    float deltaGround = b * b - (r2 - R_e * R_e);
+    if (deltaGround >= 0.0)
+    {
+        float tGround = -b - sqrt(deltaGround);
+        if (tGround > 0.0)
+            return -tGround;
+    }
+
+    float deltaAtmos = b * b - (r2 - R_a * R_a);
+    return max(-b + sqrt(max(deltaAtmos, 0.0)), 0.0);
+}
+
+void main()
+{
+    vec3 ray = atmosphereRay(viewPos, R_a);
+
+    vec2 size = vec2(textureSize(skyImage, 0));
+    vec3 acolor;
+
+    if (size == viewportSize)
+    {
+        acolor = texelFetch(skyImage, ivec2(gl_FragCoord.xy), 0).rgb;
+    }
+    else
+    {
+        // Bilateral upsampling, bilinear weights of the four nearest texels
+        //  scaled by how close their rays are to the ray of the pixel
+        vec2 uv = gl_FragCoord.xy / viewportSize;
+        float depth = rayDepth(ray);
+
+        vec2 pos = uv * size - 0.5;
+        ivec2 base = ivec2(floor(pos));
+        vec2 f = pos - vec2(base);
+
+        vec3 sum = vec3(0.0);
+        float weightSum = 0.0;
+        vec3 nearest = vec3(0.0);
+        float nearestDiff = 1e30;
+        for (int i = 0; i < 4; ++i)
+        {
+            ivec2 corner = ivec2(i & 1, i >> 1);
+            ivec2 texel = clamp(base + corner, ivec2(0), ivec2(size) - 1);
+            vec4 s = texelFetch(skyImage, texel, 0);
+            // Outside of the atmosphere
+            if (s.a == 0.0)
+                continue;
+
+            vec2 texelNdc = (vec2(texel) + 0.5) / size * 2.0 - 1.0;
+            float texelDepth = rayDepth(viewRay(texelNdc));
+
+            // The ground and the sky are never mixed
+            float diff = texelDepth * depth > 0.0 
+                ? abs(texelDepth - depth) / abs(depth) / DEPTH_SIGMA
+                : 1e3;
+
+            vec2 w = mix(1.0 - f, f, vec2(corner));
+            float weight = w.x * w.y * exp(-diff * diff);
+            sum += s.rgb * weight;
+            weightSum += weight;
+
+            if (diff < nearestDiff)
+            {
+                nearest = s.rgb;
+                nearestDiff = diff;
+            }
+        }
+
+        // No similar texel, the closest one is the best guess
+        acolor = weightSum > 1e-4 ? sum / weightSum : nearest;
+    }
+
+    // Apply tone mapping
+    acolor = mix(acolor, (1.0 - exp(-1.0 * acolor)), toneMappingFactor);
+
+    finalColor = vec4(acolor, 1.0);
+}
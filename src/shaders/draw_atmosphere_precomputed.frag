@@ -0,0 +1,156 @@
+#version 450 core
+
+#define M_PI 3.1415926535897932384626433832795
+#define MU_S_MIN (-0.2)  // Lowest cosine of the sun zenith in the tables
+
+out vec4 finalColor;
+
+uniform vec3 viewPos;   // Position of the viewer
+uniform vec3 sunPos;    // Position of the sun, light direction
+
+uniform float I_sun;    // Intensity of the sun
+uniform float R_e;      // Radius of the planet [m]
+uniform float R_a;      // Radius of the atmosphere [m]
+uniform float g;        // Mie scattering direction -
+                        //  - anisotropy of the medium
+
+uniform float toneMappingFactor;    ///< Whether tone mapping is applied
+
+// Precomputed tables, see ScatteringTables
+uniform sampler3D scatteringTexture;    // Rayleigh and multiple scattering
+uniform sampler3D mieScatteringTexture; // Single Mie scattering
+uniform vec4 scatteringSize;            // Size of the 4D table (r, mu, mu_s, nu)
+
+#include "view_ray.glsl"
+
+/**
+ * @brief Maps a parameter in [0, 1] to texture coordinates of texel centers
+ * @param x Parameter in [0, 1]
+ * @param n Number of texels
+ */
+float toTexelCenter(float x, float n)
+{
+    return 0.5 / n + x * (1.0 - 1.0 / n);
+}
+
+/**
+ * @brief Whether the ray (r, mu) intersects the ground
+ */
+bool rayIntersectsGround(float r, float mu)
+{
+    return mu < 0.0 && r * r * (mu * mu - 1.0) + R_e * R_e >= 0.0;
+}
+
+/**
+ * @brief Looks up the 4D table packed into a 3D texture,
+ *  parametrization mirrors ScatteringTables::to_uvwz
+ * @param table Either of the scattering tables
+ * @param r Distance of the point from the center of the planet
+ * @param mu Cosine of the view zenith angle
+ * @param mu_s Cosine of the sun zenith angle
+ * @param nu Cosine of the angle between the view ray and the sun
+ * @param rayGround Whether the view ray intersects the ground
+ */
+vec3 lookupScattering(sampler3D table, float r, float mu, float mu_s, float nu,
+                      bool rayGround)
+{
+    float H = sqrt(R_a * R_a - R_e * R_e);
+    float rho = sqrt(max(r * r - R_e * R_e, 0.0));
+    float u_r = toTexelCenter(clamp(rho / H, 0.0, 1.0), scatteringSize.x);
+
+    // Distance to the boundary, mapped separately for rays hitting the ground
+    float r_mu = r * mu;
+    float discriminant = r_mu * r_mu - r * r + R_e * R_e;
+    float u_mu;
+    if (rayGround)
+    {
+        float d = -r_mu - sqrt(max(discriminant, 0.0));
+        float d_min = r - R_e;
+        float d_max = rho;
+        float x = d_max == d_min ? 0.0 : (d - d_min) / (d_max - d_min);
+        u_mu = 0.5 - 0.5 * toTexelCenter(clamp(x, 0.0, 1.0), scatteringSize.y * 0.5);
+    }
+    else
+    {
+        float d = -r_mu + sqrt(max(discriminant + H * H, 0.0));
+        float d_min = R_a - r;
+        float d_max = rho + H;
+        float x = (d - d_min) / (d_max - d_min);
+        u_mu = 0.5 + 0.5 * toTexelCenter(clamp(x, 0.0, 1.0), scatteringSize.y * 0.5);
+    }
+
+    float x_mu_s = max((1.0 - exp(-3.0 * (mu_s - MU_S_MIN))) / 
+                       (1.0 - exp(-3.0 * (1.0 - MU_S_MIN))), 0.0);
+    float u_mu_s = toTexelCenter(x_mu_s, scatteringSize.z);
+
+    // Slices of nu are placed side by side, interpolate between two of them
+    float texCoordX = (nu + 1.0) * 0.5 * (scatteringSize.w - 1.0);
+    float texX = floor(texCoordX);
+    float lerp = texCoordX - texX;
+    vec3 uvw0 = vec3((texX + u_mu_s) / scatteringSize.w, u_mu, u_r);
+    vec3 uvw1 = vec3((min(texX + 1.0, scatteringSize.w - 1.0) + u_mu_s) /
+                     scatteringSize.w, u_mu, u_r);
+
+    return mix(texture(table, uvw0).rgb, texture(table, uvw1).rgb, lerp);
+}
+
+/**
+ * @brief Function to compute color of a certain view ray from the
+ *  precomputed tables
+ * @param ray Direction of the view ray
+ * @param origin Origin of the view ray
+ * @return color of the view ray
+ */
+vec3 computeSkyColor(vec3 ray, vec3 origin)
+{
+    // Normalize the light direction
+    vec3 sunDir = normalize(sunPos);
+
+    float r = length(origin);
+    float r_mu = dot(origin, ray);
+
+    // Move the viewer in space to the top of the atmosphere
+    float distToTop = -r_mu - sqrt(max(r_mu * r_mu - r * r + R_a * R_a, 0.0));
+    if (distToTop > 0.0)
+    {
+        origin += ray * distToTop;
+        r = R_a;
+        r_mu += distToTop;
+    }
+    else if (r > R_a)
+    {
+        // View ray does not hit the atmosphere
+        return vec3(0.0);
+    }
+
+    float mu = r_mu / r;
+    float mu_s = dot(origin, sunDir) / r;
+    float nu = dot(ray, sunDir);
+    bool rayGround = rayIntersectsGround(r, mu);
+
+    //--------------------------------
+    // Rayleigh and Mie Phase functions
+    float phase_R = 3.0 / (16.0 * M_PI) * (1.0 + nu * nu);
+
+    float g_2 = g * g;
+    float phase_M = 3.0 / (8.0 * M_PI) *
+                          ((1.0 - g_2) * (1.0 + nu * nu)) /
+                          ((2.0 + g_2) * pow(1.0 + g_2 - 2.0 * g * nu, 1.5));
+
+    vec3 scattering = lookupScattering(scatteringTexture, r, mu, mu_s, nu,
+                                       rayGround);
+    vec3 mie = lookupScattering(mieScatteringTexture, r, mu, mu_s, nu,
+                                rayGround);
+
+    return I_sun * (scattering * phase_R + mie * phase_M);
+}
+
+void main()
+{
+    vec3 acolor = computeSkyColor(atmosphereRay(viewPos, R_a), viewPos);
+
+    // Apply tone mapping
+    acolor = mix(acolor, (1.0 - exp(-1.0 * acolor)), toneMappingFactor);
+
+    finalColor = vec4(acolor, 1.0);
+}
@@ -0,0 +1,70 @@
+#version 450 core
+
+#define M_PI 3.1415926535897932384626433832795
+
+out vec4 finalColor;
+
+uniform vec3 viewPos;   // Position of the viewer
+uniform vec3 sunPos;    // Position of the sun, light direction
+
+uniform float R_e;      // Radius of the planet [m]
+uniform float R_a;      // Radius of the atmosphere [m]
+uniform float I_sun;    // Intensity of the sun
+
+uniform float toneMappingFactor;    ///< Whether tone mapping is applied
+
+uniform sampler2D skyViewLUT;   // Sky radiance around the viewer
+
+// Sky-view tables over the sun animation, radiance for unit intensity
+uniform bool useSequence;           // Blends the sequence instead of the table
+uniform sampler3D skyViewSequence;
+uniform vec2 sequenceLayers;        // Depth coordinates of the two nearest layers
+uniform float sequenceBlend;        // Weight of the second layer
+uniform vec3 sequenceSunDir0;       // Sun direction of each layer
+uniform vec3 sequenceSunDir1;
+
+#include "sky_view.glsl"
+#include "view_ray.glsl"
+
+/**
+ * @brief Texture coordinates of a view direction in a table of the given
+ *  sun direction, mapped to the texel centers
+ */
+vec2 skyViewUv(vec3 ray, vec3 sunDir, vec2 size)
+{
+    vec3 up, forward, side;
+    skyViewFrame(viewPos, normalize(sunDir), up, forward, side);
+
+    vec2 uv = skyViewDirectionToUv(ray, length(viewPos), up, forward);
+    return 0.5 / size + uv * (1.0 - 1.0 / size);
+}
+
+void main()
+{
+    vec3 ray = atmosphereRay(viewPos, R_a);
+
+    vec3 acolor;
+    if (useSequence)
+    {
+        // Each layer in its own frame, the sun crosses the zenith between
+        //  the layers and the frame turns around
+        vec2 size = vec2(textureSize(skyViewSequence, 0).xy);
+        vec3 color0 = texture(skyViewSequence, 
+                              vec3(skyViewUv(ray, sequenceSunDir0, size), 
+                                   sequenceLayers.x)).rgb;
+        vec3 color1 = texture(skyViewSequence, 
+                              vec3(skyViewUv(ray, sequenceSunDir1, size), 
+                                   sequenceLayers.y)).rgb;
+        acolor = mix(color0, color1, sequenceBlend) * I_sun;
+    }
+    else
+    {
+        vec2 size = vec2(textureSize(skyViewLUT, 0));
+        acolor = texture(skyViewLUT, skyViewUv(ray, sunPos, size)).rgb;
+    }
+
+    // Apply tone mapping
+    acolor = mix(acolor, (1.0 - exp(-1.0 * acolor)), toneMappingFactor);
+
+    finalColor = vec4(acolor, 1.0);
+}
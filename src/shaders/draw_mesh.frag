@@ -1,5 +1,6 @@
 #version 450
 
+in vec3 fsPosition;
 in vec2 fsTexCoord;
 //layout(location = 0) in vec3 fs_position;
 //layout(location = 1) in vec3 fs_normal;
@@ -10,9 +11,22 @@ out vec4 final_color;
 
 //uniform sampler2D tex;
 
+uniform float toneMappingFactor;    ///< Whether tone mapping is applied
+uniform bool useGroundLighting;     ///< Whether the lighting tables are baked
+
+#include "ray_marching.glsl"
+#include "ground_lighting.glsl"
+#include "aerial_perspective.glsl"
+
 void main()
 {   
     //final_color = texture(tex, fsTexCoord); 
-    final_color = vec4(0.1, 0.1, 0.1, 1.0);
-}
+    vec3 color = useGroundLighting ? groundRadiance(fsPosition, normalize(sunPos))
+                                   : vec3(0.1, 0.1, 0.1);
+    color = applyAerialPerspective(color, fsPosition);
 
+    // Apply tone mapping
+    color = mix(color, (1.0 - exp(-1.0 * color)), toneMappingFactor);
+
+    final_color = vec4(color, 1.0);
+}
@@ -4,12 +4,15 @@ layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;        // TODO unused
 layout(location = 2) in vec2 texCoord;
 
+out vec3 fsPosition;
 out vec2 fsTexCoord;
 
+uniform mat4 M;     // Model matrix
 uniform mat4 MVP;
 
 void main()
 {
+    fsPosition = vec3(M * vec4(position, 1.0));
     fsTexCoord = texCoord;
 
     gl_Position = MVP * vec4(position, 1.0);
@@ -0,0 +1,19 @@
+#version 450 core
+
+in vec2 fsTexCoord;
+
+out vec4 finalColor;
+
+uniform float toneMappingFactor;    ///< Whether tone mapping is applied
+
+uniform sampler2D referenceImage;   // Radiance rendered on the CPU
+
+void main()
+{
+    vec3 acolor = texture(referenceImage, fsTexCoord).rgb;
+
+    // Apply tone mapping
+    acolor = mix(acolor, (1.0 - exp(-1.0 * acolor)), toneMappingFactor);
+
+    finalColor = vec4(acolor, 1.0);
+}
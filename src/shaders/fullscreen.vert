@@ -0,0 +1,13 @@
+#version 450 core
+
+out vec2 fsTexCoord;
+
+void main()
+{
+    // Single triangle covering the whole viewport, generated from the
+    //  vertex index, expects an empty vertex array to be bound
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+
+    fsTexCoord = pos;
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,56 @@
+/**
+ * Ground lit by the sun and the sky, for the planet drawn by draw_mesh.frag.
+ * Expects ray_marching.glsl to be included before, for the transmittance
+ * table and the parametrization of the tables.
+ */
+
+uniform sampler2D groundIrradianceLUT;  // Sky irradiance, see GroundIrradianceLUT
+uniform float groundAlbedo;             // Lambertian reflectance of the ground
+uniform bool useSkySH;                  // Sky irradiance from SkySH, not the table
+
+// Irradiance of the sky around the viewer, see SkySH, RGB in xyz
+layout(std140) uniform SkySH
+{
+    vec4 shIrradiance[9];
+};
+
+/**
+ * @brief Irradiance of the sky on a surface near the viewer from the 
+ *  spherical harmonics of SkySH, without the intensity of the sun
+ * @param n Normal of the surface
+ */
+vec3 skyIrradianceSH(vec3 n)
+{
+    vec3 E = shIrradiance[0].rgb * 0.282095
+           + shIrradiance[1].rgb * (0.488603 * n.y)
+           + shIrradiance[2].rgb * (0.488603 * n.z)
+           + shIrradiance[3].rgb * (0.488603 * n.x)
+           + shIrradiance[4].rgb * (1.092548 * n.x * n.y)
+           + shIrradiance[5].rgb * (1.092548 * n.y * n.z)
+           + shIrradiance[6].rgb * (0.315392 * (3.0 * n.z * n.z - 1.0))
+           + shIrradiance[7].rgb * (1.092548 * n.x * n.z)
+           + shIrradiance[8].rgb * (0.546274 * (n.x * n.x - n.y * n.y));
+
+    // Ringing of the low order may go negative opposite to the sun
+    return max(E, vec3(0.0));
+}
+
+/**
+ * @brief Radiance of the ground lit by the direct sunlight and by the sky,
+ *  two table lookups, or a lookup and the SH of the sky near the viewer,
+ *  instead of integrating the hemisphere
+ * @param p Position on the surface of the planet
+ * @param sunDir Normalized direction of the light
+ */
+vec3 groundRadiance(vec3 p, vec3 sunDir)
+{
+    float mu_s = dot(normalize(p), sunDir);
+
+    vec3 sun = transmittanceToSun(p, sunDir) * max(mu_s, 0.0);
+    vec3 sky = useSkySH ? skyIrradianceSH(normalize(p)) 
+                        : texture(groundIrradianceLUT, 
+                                  altitudeSunUv(groundIrradianceLUT, p, sunDir)).rgb;
+
+    // Lambertian reflection towards any direction
+    return groundAlbedo / M_PI * (sun + sky) * I_sun;
+}
@@ -0,0 +1,662 @@
+/**
+ * Ray marched single scattering, shared by the shaders which integrate
+ * the atmosphere directly. Included via Shader::resolve_includes.
+ */
+
+#define M_PI 3.1415926535897932384626433832795
+
+// How transmittance towards the sun is computed, see Atmosphere::LightIntegrator
+#define LIGHT_RAY_MARCHING      0
+#define LIGHT_TRANSMITTANCE_LUT 1
+#define LIGHT_CHAPMAN           2
+
+// Wavelength bins of the spectral mode in groups of four, SPECTRAL_BINS / 4
+#define SPECTRAL_GROUPS 2
+
+uniform vec3 sunPos;    // Position of the sun, light direction
+
+// Number of samples along the view ray and light ray
+uniform int viewSamples;
+uniform int lightSamples;
+
+uniform float I_sun;    // Intensity of the sun
+uniform float R_e;      // Radius of the planet [m]
+uniform float R_a;      // Radius of the atmosphere [m]
+uniform vec3  beta_R;   // Rayleigh scattering coefficient
+uniform float beta_M;   // Mie scattering coefficient
+uniform float H_R;      // Rayleigh scale height
+uniform float H_M;      // Mie scale height
+uniform float g;        // Mie scattering direction - 
+                        //  - anisotropy of the medium
+
+uniform sampler2D transmittanceLUT; // Precomputed transmittance towards the sun
+uniform int lightIntegrator;        // Integrator of the light ray
+
+uniform sampler2D multipleScatteringLUT;    // Isotropic multiple scattering
+uniform bool useMultipleScattering;         // Whether the term is added
+
+uniform bool adaptiveSampling;  // Whether view samples follow the density
+
+uniform float transmittanceThreshold;   // View ray ends below, 0 disables
+uniform bool skipEmptySpace;            // Whether samples in the shadow of 
+                                        //  the planet get no sunlight, else
+                                        //  the light ray passes the planet
+
+uniform bool spectral;  // Whether computeSkyColor integrates wavelength bins
+uniform vec4 beta_R_spectral[SPECTRAL_GROUPS];  // Rayleigh scattering per bin
+uniform vec3 spectralToRgb[SPECTRAL_GROUPS * 4]; // RGB of each bin, CIE 1931
+
+int viewIterations = 0;     // Iterations of the view loop, for statistics
+int lightIterations = 0;    // Light samples, one per LUT or closed form
+
+/**
+ * @brief Computes intersection between a ray and a sphere
+ * @param o Origin of the ray
+ * @param d Direction of the ray
+ * @param r Radius of the sphere
+ * @return Roots depending on the intersection
+ */
+vec2 raySphereIntersection(vec3 o, vec3 d, float r)
+{
+    // Solving analytically as a quadratic function
+    //  assumes that the sphere is centered at the origin
+    // f(x) = a(x^2) + bx + c
+    float a = dot(d, d);
+    float b = 2.0 * dot(d, o);
+    float c = dot(o, o) - r * r;
+
+    // Discriminant or delta
+    float delta = b * b - 4.0 * a * c;
+
+    // Roots not found
+    if (delta < 0.0) {
+      // TODO
+      return vec2(1e5, -1e5);
+    }
+
+    float sqrtDelta = sqrt(delta);
+    // TODO order??
+    return vec2((-b - sqrtDelta) / (2.0 * a),
+                (-b + sqrtDelta) / (2.0 * a));
+}
+
+/**
+ * @brief Texture coordinates of a table indexed by the altitude of a point
+ *  and the sun zenith angle, parametrization mirrors TransmittanceLUT
+ * @param table Table to be looked up
+ * @param p Position of the point
+ * @param sunDir Normalized direction of the light
+ */
+vec2 altitudeSunUv(sampler2D table, vec3 p, vec3 sunDir)
+{
+    float r = length(p);
+    float mu_s = dot(p, sunDir) / r;
+    vec2 uv = vec2(mu_s * 0.5 + 0.5, 
+                   sqrt(clamp((r - R_e) / (R_a - R_e), 0.0, 1.0)));
+
+    // Map to texel centers
+    vec2 size = vec2(textureSize(table, 0));
+    return 0.5 / size + uv * (1.0 - 1.0 / size);
+}
+
+/**
+ * @brief Looks up transmittance from a point towards the sun in the
+ *  precomputed table
+ * @param p Position of the point
+ * @param sunDir Normalized direction of the light
+ * @return Transmittance for RGB wavelengths
+ */
+vec3 transmittanceToSun(vec3 p, vec3 sunDir)
+{
+    return texture(transmittanceLUT, 
+                   altitudeSunUv(transmittanceLUT, p, sunDir)).rgb;
+}
+
+/**
+ * @brief Looks up light scattered twice or more towards a point,
+ *  per unit scattering coefficient, see MultipleScatteringLUT
+ * @param p Position of the point
+ * @param sunDir Normalized direction of the light
+ */
+vec3 multipleScattering(vec3 p, vec3 sunDir)
+{
+    return texture(multipleScatteringLUT, 
+                   altitudeSunUv(multipleScatteringLUT, p, sunDir)).rgb;
+}
+
+/**
+ * @brief Integrates optical depth from a point towards the sun by 
+ *  ray marching the light (secondary) ray
+ * @param p Position of the point
+ * @param sunDir Normalized direction of the light
+ * @return Optical depth (Rayleigh, Mie)
+ */
+vec2 opticalDepthLightRay(vec3 p, vec3 sunDir)
+{
+    float segmentLenLight = 
+        raySphereIntersection(p, sunDir, R_a).y / float(lightSamples);
+    float tCurrentLight = 0.0;
+
+    // Light optical depth 
+    float optDepthLight_R = 0.0;
+    float optDepthLight_M = 0.0;
+
+    // Sample along the light ray
+    for (int j = 0; j < lightSamples; ++j)
+    {
+        // Position of the light ray sample
+        vec3 lSample = p + sunDir * (tCurrentLight + segmentLenLight * 0.5);
+        // Height of the light ray sample
+        float heightLight = length(lSample) - R_e;
+
+        // TODO check sample above the ground
+        
+        optDepthLight_R += exp(-heightLight / H_R) * segmentLenLight;
+        optDepthLight_M += exp(-heightLight / H_M) * segmentLenLight;
+
+        // Next light sample
+        tCurrentLight += segmentLenLight;
+    }
+
+    return vec2(optDepthLight_R, optDepthLight_M);
+}
+
+/**
+ * @brief Integrates transmittance from a point towards the sun by 
+ *  ray marching the light (secondary) ray
+ * @param p Position of the point
+ * @param sunDir Normalized direction of the light
+ * @return Transmittance for RGB wavelengths
+ */
+vec3 transmittanceLightRay(vec3 p, vec3 sunDir)
+{
+    vec2 optDepthLight = opticalDepthLightRay(p, sunDir);
+
+    // Mie extenction coeff. = 1.1 of the Mie scattering coeff.
+    return exp(-(beta_R * optDepthLight.x + beta_M * 1.1f * optDepthLight.y));
+}
+
+/**
+ * @brief Whether the planet hides the sun from a point
+ * @param p Position of the point
+ * @param sunDir Normalized direction of the light
+ */
+bool sunOccluded(vec3 p, vec3 sunDir)
+{
+    float r = length(p);
+    float mu_s = dot(p, sunDir) / r;
+    return mu_s < 0.0 && r * r * (mu_s * mu_s - 1.0) + R_e * R_e >= 0.0;
+}
+
+/**
+ * @brief Scaled complementary error function exp(y^2) * erfc(y), y >= 0.
+ *  Abramowitz and Stegun 7.1.26 close to zero, asymptotic series further,
+ *  relative error below 0.1 %
+ */
+float erfcx(float y)
+{
+    if (y < 3.0)
+    {
+        float t = 1.0 / (1.0 + 0.3275911 * y);
+        return t * (0.254829592 + t * (-0.284496736 + t * (1.421413741 + 
+                    t * (-1.453152027 + t * 1.061405429))));
+    }
+
+    float y_2 = 1.0 / (y * y);
+    return (1.0 - 0.5 * y_2 + 0.75 * y_2 * y_2) / (sqrt(M_PI) * y);
+}
+
+/**
+ * @brief Optical depth of an exponential density profile from a point 
+ *  to the infinity, in closed form using the Chapman function
+ *      Ch(x, mu) ~ sqrt(pi * x / 2) * erfcx(sqrt(x / 2) * mu),  x = r / H
+ *  Rays below the horizontal pass through the lowest point of the ray
+ *  twice, the density there is accounted for analytically as well.
+ * @param r Distance of the point from the center of the planet
+ * @param mu Cosine of the zenith angle of the ray
+ * @param H Scale height of the density profile
+ */
+float chapmanOpticalDepth(float r, float mu, float H)
+{
+    float x = r / H;
+    float chapman = sqrt(0.5 * M_PI * x) * erfcx(sqrt(0.5 * x) * abs(mu));
+    float densityHere = exp(-(r - R_e) / H);
+
+    if (mu >= 0.0)
+        return H * densityHere * chapman;
+
+    // Lowest point of the ray at distance r * sin(zenith) from the center
+    float rLow = r * sqrt(1.0 - mu * mu);
+    float densityLow = exp(-(rLow - R_e) / H);
+    return H * (2.0 * sqrt(0.5 * M_PI * rLow / H) * densityLow - 
+                densityHere * chapman);
+}
+
+/**
+ * @brief Optical depth from a point towards the sun in closed form,
+ *  the sun must not be occluded by the planet
+ * @param p Position of the point
+ * @param sunDir Normalized direction of the light
+ * @return Optical depth (Rayleigh, Mie)
+ */
+vec2 opticalDepthChapman(vec3 p, vec3 sunDir)
+{
+    float r = length(p);
+    float mu_s = dot(p, sunDir) / r;
+
+    return vec2(chapmanOpticalDepth(r, mu_s, H_R), 
+                chapmanOpticalDepth(r, mu_s, H_M));
+}
+
+/**
+ * @brief Transmittance from a point towards the sun in closed form
+ * @param p Position of the point
+ * @param sunDir Normalized direction of the light
+ * @return Transmittance for RGB wavelengths
+ */
+vec3 transmittanceChapman(vec3 p, vec3 sunDir)
+{
+    if (sunOccluded(p, sunDir))
+        return vec3(0.0);
+
+    vec2 optDepthLight = opticalDepthChapman(p, sunDir);
+
+    // Mie extenction coeff. = 1.1 of the Mie scattering coeff.
+    return exp(-(beta_R * optDepthLight.x + beta_M * 1.1f * optDepthLight.y));
+}
+
+/**
+ * @brief Number of view samples of a segment in the adaptive mode, short
+ *  segments high in the atmosphere need fewer samples than long ones
+ *  along the horizon
+ * @param len Length of the segment
+ */
+int adaptiveSampleCount(float len)
+{
+    // Length of a ray along the horizon from the ground
+    float horizonLen = sqrt(R_a * R_a - R_e * R_e);
+    float fraction = 0.5 + 0.5 * sqrt(len / horizonLen);
+
+    return min(max(int(ceil(float(viewSamples) * fraction)), 2), viewSamples);
+}
+
+/**
+ * @brief Spacing of the view samples in the adaptive mode. Samples follow 
+ *  the cumulative density of an exponential atmosphere of twice the 
+ *  Rayleigh scale height, between the density and uniform spacing. The 
+ *  height along each side of the lowest point of the segment is taken
+ *  as linear, the density is then exponential in the distance and its
+ *  integral is inverted in closed form.
+ */
+struct AdaptiveSpacing
+{
+    float t0, tLow, t1;     // Segment and its lowest point
+    float rho0, k0;         // Density at t0 and its rate towards tLow
+    float rhoLow, k1;       // Density at tLow and its rate towards t1
+    float mass0, mass;      // Integral of the density up to tLow and in total
+};
+
+// Integral of the density rho * exp(k * x) from 0 to x, linear when k is 0
+float spacingMass(float rho, float k, float x)
+{
+    return k == 0.0 ? rho * x : rho * (exp(k * x) - 1.0) / k;
+}
+
+// Distance from the start of a side where the integral reaches m
+float spacingDistance(float rho, float k, float m)
+{
+    return k == 0.0 ? m / rho : log(max(1.0 + m * k / rho, 1e-6)) / k;
+}
+
+// Rate of the density along a side of length len between heights h_a, h_b
+float spacingRate(float h_a, float h_b, float len, float H)
+{
+    // Nearly constant density, the exponential form loses precision
+    float k = (h_a - h_b) / (len * H);
+    return abs(k * len) < 1e-3 ? 0.0 : k;
+}
+
+/**
+ * @brief Spacing of the view samples over a segment of a view ray
+ * @param origin Origin of the view ray
+ * @param ray Direction of the view ray
+ * @param t0 Start of the segment
+ * @param t1 End of the segment
+ */
+AdaptiveSpacing adaptiveSpacing(vec3 origin, vec3 ray, float t0, float t1)
+{
+    float H = 2.0 * H_R;
+    AdaptiveSpacing s;
+    s.t0 = t0;
+    s.t1 = t1;
+    s.tLow = clamp(-dot(origin, ray), t0, t1);
+
+    float h0 = length(origin + ray * t0) - R_e;
+    float hLow = length(origin + ray * s.tLow) - R_e;
+    float h1 = length(origin + ray * t1) - R_e;
+    float len0 = s.tLow - t0;
+    float len1 = t1 - s.tLow;
+
+    s.rho0 = exp(-h0 / H);
+    s.rhoLow = exp(-hLow / H);
+    s.k0 = len0 > 0.0 ? spacingRate(h0, hLow, len0, H) : 0.0;
+    s.k1 = len1 > 0.0 ? spacingRate(hLow, h1, len1, H) : 0.0;
+    s.mass0 = spacingMass(s.rho0, s.k0, len0);
+    s.mass = s.mass0 + spacingMass(s.rhoLow, s.k1, len1);
+    return s;
+}
+
+/**
+ * @brief Maps a parameter in [0, 1] to a distance along the segment of
+ *  the spacing, equal steps of u enclose equal integrals of the density
+ */
+float adaptiveDistance(float u, AdaptiveSpacing s)
+{
+    if (u >= 1.0)
+        return s.t1;
+
+    float m = u * s.mass;
+    if (m <= s.mass0)
+        return s.t0 + min(spacingDistance(s.rho0, s.k0, m), s.tLow - s.t0);
+    return s.tLow + min(spacingDistance(s.rhoLow, s.k1, m - s.mass0), 
+                        s.t1 - s.tLow);
+}
+
+/**
+ * @brief Integrates single scattering along a segment of a view ray,
+ *  the segment is clipped to the atmosphere and the ground. The Mie phase 
+ *  function is left to the caller, it is the only term too sharp to be
+ *  interpolated between the vertices of the dome mode.
+ * @param ray Direction of the view ray
+ * @param origin Origin of the view ray
+ * @param tMax Distance from the origin where the segment ends
+ * @param mie Light in-scattered by aerosols towards the origin, without 
+ *            the phase function
+ * @param transmittance Transmittance along the segment
+ * @return Rayleigh and multiple scattering towards the origin
+ */
+vec3 integrateScatteringSplit(vec3 ray, vec3 origin, float tMax, out vec3 mie,
+                              out vec3 transmittance)
+{
+    mie = vec3(0.0);
+    transmittance = vec3(1.0);
+
+    // Normalize the light direction
+    vec3 sunDir = normalize(sunPos);
+
+    vec2 t = raySphereIntersection(origin, ray, R_a);
+    // Intersects behind
+    if (t.x > t.y || t.y < 0.0) {
+        return vec3(0.0, 0.0, 0.0);
+    }
+
+    // Start at the viewer when inside of the atmosphere, stop at the ground
+    t.x = max(t.x, 0.0);
+    float tGround = raySphereIntersection(origin, ray, R_e).x;
+    if (tGround > 0.0)
+        t.y = min(t.y, tGround);
+    t.y = min(t.y, tMax);
+    if (t.y <= t.x) {
+        return vec3(0.0, 0.0, 0.0);
+    }
+
+    // Number of samples and their spacing, the densest at the lowest point
+    int samples = viewSamples;
+    AdaptiveSpacing spacing;
+    if (adaptiveSampling)
+    {
+        samples = adaptiveSampleCount(t.y - t.x);
+        spacing = adaptiveSpacing(origin, ray, t.x, t.y);
+    }
+    // Long adaptive segments are attenuated to their middle, not to their
+    //  end, the bias of the end grows with the length
+    float attenuatedPart = adaptiveSampling ? 0.5 : 0.0;
+
+    float tCurrent = t.x;
+
+    // Rayleigh and Mie contribution
+    vec3 sum_R = vec3(0);
+    vec3 sum_M = vec3(0);
+    // Multiple scattering contribution
+    vec3 sum_MS = vec3(0);
+
+    // Optical depth 
+    float optDepth_R = 0.0;
+    float optDepth_M = 0.0;
+
+    // Mu: the cosine angle between the sun and ray direction
+    float mu = dot(ray, sunDir);
+    float mu_2 = mu * mu;
+    
+    //--------------------------------
+    // Rayleigh Phase function
+    float phase_R = 3.0 / (16.0 * M_PI) * (1.0 + mu_2);
+
+    // Sample along the view ray
+    for (int i = 0; i < samples; ++i)
+    {
+        // Distance between samples - length of each segment
+        float u = float(i + 1) / float(samples);
+        float tNext = adaptiveSampling ? adaptiveDistance(u, spacing)
+                                       : mix(t.x, t.y, u);
+        float segmentLen = tNext - tCurrent;
+
+        // Middle point of the sample position
+        vec3 vSample = origin + ray * (tCurrent + segmentLen * 0.5);
+
+        // Height of the sample above the planet
+        float height = length(vSample) - R_e;
+
+        // Optical depth for Rayleigh and Mie scattering for current sample
+        float h_R = exp(-height / H_R) * segmentLen;
+        float h_M = exp(-height / H_M) * segmentLen;
+        optDepth_R += h_R;
+        optDepth_M += h_M;
+
+        // Attenuation of the light along the view ray
+        //  Mie extenction coeff. = 1.1 of the Mie scattering coeff.
+        vec3 viewAtt = exp(-(beta_R * (optDepth_R - attenuatedPart * h_R) + 
+                             beta_M * 1.1f * (optDepth_M - attenuatedPart * h_M)));
+        vec3 att = viewAtt;
+        ++viewIterations;
+
+        // In the shadow of the planet, single scattering does not contribute
+        if (!skipEmptySpace || !sunOccluded(vSample, sunDir))
+        {
+            lightIterations += 
+                lightIntegrator == LIGHT_RAY_MARCHING ? lightSamples : 1;
+            //--------------------------------
+            // Secondary - light ray
+            if (lightIntegrator == LIGHT_TRANSMITTANCE_LUT)
+                att *= transmittanceToSun(vSample, sunDir);
+            else if (lightIntegrator == LIGHT_CHAPMAN)
+                att *= transmittanceChapman(vSample, sunDir);
+            else
+                att *= transmittanceLightRay(vSample, sunDir);
+
+            // Accumulate the scattering 
+            sum_R += h_R * att;
+            sum_M += h_M * att;
+        }
+
+        // Higher orders are isotropic, no phase function
+        if (useMultipleScattering)
+            sum_MS += viewAtt * multipleScattering(vSample, sunDir) * 
+                      (beta_R * h_R + beta_M * h_M);
+
+        // Next view sample
+        tCurrent = tNext;
+
+        // Nothing behind can be seen through
+        if (max(viewAtt.r, max(viewAtt.g, viewAtt.b)) < transmittanceThreshold)
+            break;
+    }
+
+    transmittance = exp(-(beta_R * optDepth_R + beta_M * 1.1f * optDepth_M));
+
+    mie = I_sun * sum_M * beta_M;
+    return I_sun * (sum_R * beta_R * phase_R + sum_MS);
+}
+
+/**
+ * @brief Integrates single scattering along a segment of a view ray,
+ *  the segment is clipped to the atmosphere and the ground
+ * @param ray Direction of the view ray
+ * @param origin Origin of the view ray
+ * @param tMax Distance from the origin where the segment ends
+ * @param transmittance Transmittance along the segment
+ * @return In-scattered light towards the origin
+ */
+vec3 integrateScattering(vec3 ray, vec3 origin, float tMax, out vec3 transmittance)
+{
+    vec3 mie;
+    vec3 color = integrateScatteringSplit(ray, origin, tMax, mie, transmittance);
+
+    //--------------------------------
+    // Mie Phase function
+    float mu = dot(ray, normalize(sunPos));
+    float mu_2 = mu * mu;
+    float g_2 = g * g;
+    float phase_M = 3.0 / (8.0 * M_PI) * 
+                          ((1.0 - g_2) * (1.0 + mu_2)) / 
+                          ((2.0 + g_2) * pow(1.0 + g_2 - 2.0 * g * mu, 1.5));
+
+    return color + mie * phase_M;
+}
+
+/**
+ * @brief Integrates single scattering along a view ray for the wavelength
+ *  bins of the spectral mode, converted to RGB at the end. Densities and
+ *  light rays are shared by all the bins, only the attenuation is evaluated
+ *  per bin, four at once. Transmittance towards the sun is ray marched or
+ *  in closed form, the tables hold RGB only, so the table integrator 
+ *  uses the closed form. Higher orders of scattering are not included.
+ * @param ray Direction of the view ray
+ * @param origin Origin of the view ray
+ * @return In-scattered light towards the origin in RGB
+ */
+vec3 integrateScatteringSpectral(vec3 ray, vec3 origin)
+{
+    vec3 sunDir = normalize(sunPos);
+
+    vec2 t = raySphereIntersection(origin, ray, R_a);
+    if (t.x > t.y || t.y < 0.0) {
+        return vec3(0.0, 0.0, 0.0);
+    }
+
+    t.x = max(t.x, 0.0);
+    float tGround = raySphereIntersection(origin, ray, R_e).x;
+    if (tGround > 0.0)
+        t.y = min(t.y, tGround);
+    if (t.y <= t.x) {
+        return vec3(0.0, 0.0, 0.0);
+    }
+
+    int samples = viewSamples;
+    AdaptiveSpacing spacing;
+    if (adaptiveSampling)
+    {
+        samples = adaptiveSampleCount(t.y - t.x);
+        spacing = adaptiveSpacing(origin, ray, t.x, t.y);
+    }
+    float attenuatedPart = adaptiveSampling ? 0.5 : 0.0;
+
+    float tCurrent = t.x;
+
+    vec4 sum_R[SPECTRAL_GROUPS];
+    vec4 sum_M[SPECTRAL_GROUPS];
+    for (int k = 0; k < SPECTRAL_GROUPS; ++k)
+    {
+        sum_R[k] = vec4(0.0);
+        sum_M[k] = vec4(0.0);
+    }
+
+    float optDepth_R = 0.0;
+    float optDepth_M = 0.0;
+
+    for (int i = 0; i < samples; ++i)
+    {
+        float u = float(i + 1) / float(samples);
+        float tNext = adaptiveSampling ? adaptiveDistance(u, spacing)
+                                       : mix(t.x, t.y, u);
+        float segmentLen = tNext - tCurrent;
+
+        vec3 vSample = origin + ray * (tCurrent + segmentLen * 0.5);
+        float height = length(vSample) - R_e;
+
+        float h_R = exp(-height / H_R) * segmentLen;
+        float h_M = exp(-height / H_M) * segmentLen;
+        optDepth_R += h_R;
+        optDepth_M += h_M;
+        ++viewIterations;
+
+        // Attenuation along the view ray, for the termination
+        float maxViewAtt = 0.0;
+        for (int k = 0; k < SPECTRAL_GROUPS; ++k)
+        {
+            vec4 viewAtt = exp(-(beta_R_spectral[k] * optDepth_R + 
+                                 beta_M * 1.1f * optDepth_M));
+            maxViewAtt = max(maxViewAtt, max(max(viewAtt.x, viewAtt.y), 
+                                             max(viewAtt.z, viewAtt.w)));
+        }
+
+        // In the shadow of the planet, single scattering does not contribute
+        if (!skipEmptySpace || !sunOccluded(vSample, sunDir))
+        {
+            lightIterations += 
+                lightIntegrator == LIGHT_RAY_MARCHING ? lightSamples : 1;
+            vec2 optDepthLight = lightIntegrator == LIGHT_RAY_MARCHING
+                                    ? opticalDepthLightRay(vSample, sunDir)
+                                    : opticalDepthChapman(vSample, sunDir);
+            float tau_R = optDepth_R - attenuatedPart * h_R + optDepthLight.x;
+            float tau_M = optDepth_M - attenuatedPart * h_M + optDepthLight.y;
+
+            for (int k = 0; k < SPECTRAL_GROUPS; ++k)
+            {
+                vec4 att = exp(-(beta_R_spectral[k] * tau_R + 
+                                 beta_M * 1.1f * tau_M));
+                sum_R[k] += h_R * att;
+                sum_M[k] += h_M * att;
+            }
+        }
+
+        tCurrent = tNext;
+
+        if (maxViewAtt < transmittanceThreshold)
+            break;
+    }
+
+    float mu = dot(ray, sunDir);
+    float mu_2 = mu * mu;
+    float phase_R = 3.0 / (16.0 * M_PI) * (1.0 + mu_2);
+    float g_2 = g * g;
+    float phase_M = 3.0 / (8.0 * M_PI) * 
+                          ((1.0 - g_2) * (1.0 + mu_2)) / 
+                          ((2.0 + g_2) * pow(1.0 + g_2 - 2.0 * g * mu, 1.5));
+
+    vec3 color = vec3(0.0);
+    for (int k = 0; k < SPECTRAL_GROUPS; ++k)
+    {
+        vec4 radiance = I_sun * (sum_R[k] * beta_R_spectral[k] * phase_R + 
+                                 sum_M[k] * beta_M * phase_M);
+        for (int j = 0; j < 4; ++j)
+            color += spectralToRgb[k * 4 + j] * radiance[j];
+    }
+
+    return color;
+}
+
+/**
+ * @brief Function to compute color of a certain view ray
+ * @param ray Direction of the view ray
+ * @param origin Origin of the view ray
+ * @return color of the view ray
+ */
+vec3 computeSkyColor(vec3 ray, vec3 origin)
+{
+    if (spectral)
+        return integrateScatteringSpectral(ray, origin);
+
+    vec3 transmittance;
+    return integrateScattering(ray, origin, 1e9, transmittance);
+}
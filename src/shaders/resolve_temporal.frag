@@ -0,0 +1,102 @@
+#version 450 core
+
+out vec4 finalColor;
+
+uniform vec3 viewPos;       // Position of the viewer
+uniform float R_a;          // Radius of the atmosphere
+
+uniform mat4 invProj;       // Inverse projection of this frame
+uniform mat3 invView;       // Rotation from the view space to the world
+uniform mat4 prevProjView;  // View-projection of the last frame
+
+uniform sampler2D lattices;     // Pixels shaded in this frame, one lattice
+                                //  above the other, alpha marks the atmosphere
+uniform ivec2 latticeSize;      // Size of a single lattice
+uniform int latticeCount;       // Lattices shaded in this frame, 1 or 2
+uniform ivec2 latticeOffset[2]; // Pixel of each 2x2 block in each lattice
+
+uniform sampler2D history;      // Reconstructed radiance of the last frame
+uniform bool historyValid;      // Whether the history can be reprojected
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    // Shaded in this frame
+    for (int k = 0; k < latticeCount; ++k)
+    {
+        if ((pixel & 1) == latticeOffset[k])
+        {
+            ivec2 texel = pixel / 2 + ivec2(0, k * latticeSize.y);
+            finalColor = texelFetch(lattices, texel, 0);
+            return;
+        }
+    }
+
+    // Neighbours shaded in this frame, bilinear fill and the range of colors
+    vec4 spatial = vec4(0.0);
+    vec3 minColor = vec3(1e30);
+    vec3 maxColor = vec3(-1e30);
+    for (int k = 0; k < latticeCount; ++k)
+    {
+        vec2 pos = vec2(pixel - latticeOffset[k]) * 0.5;
+        ivec2 base = ivec2(floor(pos));
+        vec2 f = pos - vec2(base);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            ivec2 corner = ivec2(i & 1, i >> 1);
+            ivec2 texel = clamp(base + corner, ivec2(0), latticeSize - 1);
+            vec4 s = texelFetch(lattices, texel + ivec2(0, k * latticeSize.y), 0);
+
+            vec2 w = mix(1.0 - f, f, vec2(corner));
+            spatial += s * w.x * w.y;
+            if (s.a > 0.0)
+            {
+                minColor = min(minColor, s.rgb);
+                maxColor = max(maxColor, s.rgb);
+            }
+        }
+    }
+
+    // View ray through the center of the pixel, the near plane in the view
+    //  space is well conditioned for distant far planes
+    vec2 ndc = (gl_FragCoord.xy / vec2(textureSize(history, 0))) * 2.0 - 1.0;
+    vec4 nearPoint = invProj * vec4(ndc, -1.0, 1.0);
+    vec3 dir = normalize(invView * (nearPoint.xyz / nearPoint.w));
+
+    // Point on the top of the atmosphere, moves with the camera like the sky
+    float b = dot(dir, viewPos);
+    float c = dot(viewPos, viewPos) - R_a * R_a;
+    float delta = b * b - c;
+    if (delta < 0.0 || (c > 0.0 && b > 0.0))
+    {
+        // Misses the atmosphere
+        finalColor = vec4(0.0);
+        return;
+    }
+    float t = c > 0.0 ? -b - sqrt(delta) : -b + sqrt(delta);
+    vec3 shellPoint = viewPos + dir * t;
+
+    if (historyValid && maxColor.r >= minColor.r)
+    {
+        vec4 prevClip = prevProjView * vec4(shellPoint, 1.0);
+        vec2 prevUv = prevClip.xy / prevClip.w * 0.5 + 0.5;
+        bool onScreen = prevClip.w > 0.0 && 
+                        all(greaterThanEqual(prevUv, vec2(0.0))) &&
+                        all(lessThanEqual(prevUv, vec2(1.0)));
+
+        // Pixels outside of the atmosphere in the last frame are disoccluded,
+        //  the range of the neighbours suppresses ghosting of a moving sun
+        vec4 prev = textureLod(history, prevUv, 0.0);
+        if (onScreen && prev.a > 0.999)
+        {
+            finalColor = vec4(clamp(prev.rgb, minColor, maxColor), 1.0);
+            return;
+        }
+    }
+
+    // Interpolated from the lattices, the pixels without the atmosphere
+    //  do not darken the edge
+    finalColor = vec4(spatial.rgb / max(spatial.a, 1e-6), 1.0);
+}
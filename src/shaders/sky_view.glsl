@@ -0,0 +1,101 @@
+/**
+ * Parametrization of the sky-view table, shared by the pass which fills
+ * the table and the pass which reads it. Latitude is relative to the
+ * horizon and squeezed non-linearly towards it, where the sky changes
+ * the most. Longitude is relative to the sun, the sky is symmetric around
+ * the plane of the sun, so half of the circle is enough.
+ *
+ * Expects uniform R_e to be declared by the including shader.
+ */
+
+/**
+ * @brief Builds a frame around the viewer
+ * @param viewPos Position of the viewer
+ * @param sunDir Normalized direction of the light
+ * @param up Zenith direction
+ * @param forward Direction towards the sun projected to the horizon plane
+ * @param side Completes the orthonormal frame
+ */
+void skyViewFrame(vec3 viewPos, vec3 sunDir, 
+                  out vec3 up, out vec3 forward, out vec3 side)
+{
+    up = normalize(viewPos);
+    forward = sunDir - up * dot(sunDir, up);
+
+    // Sun in the zenith or nadir, any horizontal direction will do
+    if (dot(forward, forward) < 1e-8)
+        forward = cross(up, abs(up.x) < 0.9 ? vec3(1, 0, 0) : vec3(0, 1, 0));
+
+    forward = normalize(forward);
+    side = cross(up, forward);
+}
+
+/**
+ * @brief Angle between the horizon and the nadir as seen from distance r
+ */
+float horizonNadirAngle(float r)
+{
+    r = max(r, R_e);
+    return acos(sqrt(r * r - R_e * R_e) / r);
+}
+
+/**
+ * @brief Maps texture coordinates in [0, 1] to a view direction
+ */
+vec3 skyViewUvToDirection(vec2 uv, float r, vec3 up, vec3 forward, vec3 side)
+{
+    float beta = horizonNadirAngle(r);
+    float zenithHorizonAngle = M_PI - beta;
+
+    // Lower half of the table is below the horizon
+    float viewZenithAngle;
+    if (uv.y < 0.5)
+    {
+        float coord = 1.0 - 2.0 * uv.y;
+        viewZenithAngle = zenithHorizonAngle * (1.0 - coord * coord);
+    }
+    else
+    {
+        float coord = 2.0 * uv.y - 1.0;
+        viewZenithAngle = zenithHorizonAngle + beta * coord * coord;
+    }
+
+    float cosSunAzimuth = 1.0 - 2.0 * uv.x * uv.x;
+    float sinSunAzimuth = sqrt(max(1.0 - cosSunAzimuth * cosSunAzimuth, 0.0));
+
+    return up * cos(viewZenithAngle) + sin(viewZenithAngle) *
+           (forward * cosSunAzimuth + side * sinSunAzimuth);
+}
+
+/**
+ * @brief Maps a view direction to texture coordinates in [0, 1],
+ *  inverse of skyViewUvToDirection
+ */
+vec2 skyViewDirectionToUv(vec3 dir, float r, vec3 up, vec3 forward)
+{
+    float beta = horizonNadirAngle(r);
+    float zenithHorizonAngle = M_PI - beta;
+
+    float cosViewZenith = dot(dir, up);
+    float viewZenithAngle = acos(clamp(cosViewZenith, -1.0, 1.0));
+
+    vec2 uv;
+    if (viewZenithAngle < zenithHorizonAngle)
+    {
+        float coord = sqrt(1.0 - viewZenithAngle / zenithHorizonAngle);
+        uv.y = 0.5 - 0.5 * coord;
+    }
+    else
+    {
+        float coord = sqrt((viewZenithAngle - zenithHorizonAngle) / beta);
+        uv.y = 0.5 + 0.5 * coord;
+    }
+
+    // Azimuth undefined in the zenith or nadir, any column will do
+    vec3 horizontal = dir - up * cosViewZenith;
+    float len = length(horizontal);
+    float cosSunAzimuth = len > 1e-6 ? dot(horizontal / len, forward) : 1.0;
+    uv.x = sqrt(clamp(0.5 - 0.5 * cosSunAzimuth, 0.0, 1.0));
+
+    return uv;
+}
@@ -0,0 +1,24 @@
+/**
+ * View rays of the fullscreen triangle drawn by draw_atmosphere.vert.
+ */
+
+in vec3 fsRay;  // Direction of the view ray, not normalized
+
+/**
+ * @brief Normalized view ray of the fragment, discards the fragment when
+ *  the ray misses the atmosphere
+ * @param viewPos Position of the viewer
+ * @param r Radius of the atmosphere
+ */
+vec3 atmosphereRay(vec3 viewPos, float r)
+{
+    vec3 ray = normalize(fsRay);
+
+    // Outside of the atmosphere and looking away or past it
+    float b = dot(ray, viewPos);
+    float c = dot(viewPos, viewPos) - r * r;
+    if (c > 0.0 && (b > 0.0 || b * b < c))
+        discard;
+
+    return ray;
+}